@@ -235,13 +235,29 @@ class _MyHomePageState extends State<MyHomePage> {
                                         Text(type),
                                       ),
                                       DataCell(
-                                        IconButton(
-                                          icon:
-                                              const Icon(Icons.delete_outlined),
-                                          onPressed: () {
-                                            closeWindow(windowId);
-                                            resetWindowId(windowId);
-                                          },
+                                        Row(
+                                          mainAxisSize: MainAxisSize.min,
+                                          children: [
+                                            if (window['parent'] != null)
+                                              IconButton(
+                                                icon: const Icon(
+                                                    Icons.open_with_outlined),
+                                                tooltip:
+                                                    'Reposition with the current preset',
+                                                onPressed: () =>
+                                                    repositionWithCurrentPreset(
+                                                        windowId,
+                                                        window['parent']),
+                                              ),
+                                            IconButton(
+                                              icon: const Icon(
+                                                  Icons.delete_outlined),
+                                              onPressed: () {
+                                                closeWindow(windowId);
+                                                resetWindowId(windowId);
+                                              },
+                                            ),
+                                          ],
                                         ),
                                       ),
                                     ],
@@ -367,7 +383,8 @@ class _MyHomePageState extends State<MyHomePage> {
                                                             'constraintAdjustments'],
                                                   ),
                                                 );
-                                                await setWindowId(windowId);
+                                                await setWindowId(windowId,
+                                                    parent: windows[selectedRowIndex]['id']);
                                                 setState(() {
                                                   // Cycle through presets when the last one (Custom preset) is not selected
                                                   if (positionerIndex !=
@@ -419,7 +436,8 @@ class _MyHomePageState extends State<MyHomePage> {
                                                             'constraintAdjustments'],
                                                   ),
                                                 );
-                                                await setWindowId(windowId);
+                                                await setWindowId(windowId,
+                                                    parent: windows[selectedRowIndex]['id']);
                                                 setState(() {
                                                   // Cycle through presets when the last one (Custom preset) is not selected
                                                   if (positionerIndex !=
@@ -471,7 +489,8 @@ class _MyHomePageState extends State<MyHomePage> {
                                                             'constraintAdjustments'],
                                                   ),
                                                 );
-                                                await setWindowId(windowId);
+                                                await setWindowId(windowId,
+                                                    parent: windows[selectedRowIndex]['id']);
                                                 setState(() {
                                                   // Cycle through presets when the last one (Custom preset) is not selected
                                                   if (positionerIndex !=
@@ -704,14 +723,55 @@ class _MyHomePageState extends State<MyHomePage> {
     return id;
   }
 
+  void repositionWindow(
+      int windowId, Rect anchorRect, FlutterViewPositioner positioner) {
+    int constraintAdjustmentBitmask = 0;
+    for (var adjustment in positioner.constraintAdjustment) {
+      constraintAdjustmentBitmask |= 1 << adjustment.index;
+    }
+    windowChannel.invokeMethod('repositionWindow', [
+      windowId,
+      anchorRect.left,
+      anchorRect.top,
+      anchorRect.width,
+      anchorRect.height,
+      positioner.parentAnchor.index,
+      positioner.childAnchor.index,
+      positioner.offset.dx,
+      positioner.offset.dy,
+      constraintAdjustmentBitmask
+    ]);
+  }
+
+  Future<void> repositionWithCurrentPreset(int windowId, int parent) async {
+    final preset = positionerSettings[positionerIndex];
+    repositionWindow(
+      windowId,
+      anchorRectClampedToSize(await getWindowSize(parent)),
+      FlutterViewPositioner(
+        parentAnchor: preset['parentAnchor'],
+        childAnchor: preset['childAnchor'],
+        offset: preset['offset'],
+        constraintAdjustment: preset['constraintAdjustments'],
+      ),
+    );
+    setState(() {
+      // Cycle through presets when the last one (Custom preset) is not selected
+      if (positionerIndex != positionerSettings.length - 1) {
+        positionerIndex =
+            (positionerIndex + 1) % (positionerSettings.length - 1);
+      }
+    });
+  }
+
   void closeWindow(int windowId) {
     windowChannel.invokeMethod('closeWindow', [windowId]);
   }
 
-  Future<void> setWindowId(int windowId) async {
+  Future<void> setWindowId(int windowId, {int? parent}) async {
     final windowType = await getWindowType(windowId);
     setState(() {
-      windows.add({"id": windowId, "type": windowType});
+      windows.add({"id": windowId, "type": windowType, "parent": parent});
     });
   }
 
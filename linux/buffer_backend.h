@@ -0,0 +1,37 @@
+#ifndef BUFFER_BACKEND_H_
+#define BUFFER_BACKEND_H_
+
+#include <cstddef>
+#include <cstdint>
+
+struct wl_buffer;
+
+namespace mir_flutter_app
+{
+// Provides the CPU-mapped memory behind the wl_buffers that windows draw into
+class BufferBackend
+{
+public:
+    struct Memory
+    {
+        wl_buffer* buffer{};
+        void* data{};
+        int32_t stride{};
+        size_t size{};
+        int fd{-1};
+    };
+
+    virtual ~BufferBackend() = default;
+
+    // Formats are wl_shm format codes regardless of the backend
+    virtual auto supports_format(uint32_t format) const -> bool = 0;
+    virtual auto allocate(int32_t width, int32_t height, uint32_t format) -> Memory = 0;
+    virtual void destroy(Memory& memory) = 0;
+
+    // Bracket every CPU access to the memory
+    virtual void begin_access(Memory const& /*memory*/) {}
+    virtual void end_access(Memory const& /*memory*/) {}
+};
+}
+
+#endif // BUFFER_BACKEND_H_
@@ -22,13 +22,26 @@ mfa::DecoratedXdgPopupWindow::DecoratedXdgPopupWindow(
     show();
 }
 
-void mfa::DecoratedXdgPopupWindow::draw_new_content(Buffer* buffer)
+auto mfa::DecoratedXdgPopupWindow::content_painter() const -> Painter
 {
-    auto* mir_window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
-    if (!mir_window) return;
+    auto const* const mir_window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
+    Look const look{
+        .config = config_,
+        .alpha = alpha,
+        .intensity_offset = intensity_offset,
+        .id = mir_window ? mir_window->id : -1,
+        .parent_id = mir_window && mir_window->parent ? mir_window->parent->id : -1};
 
-    auto const x{config_.stroke_width / 2};
-    auto const y{config_.stroke_width / 2};
+    return [look](Buffer* buffer) { draw_decorations(buffer, look); };
+}
+
+void mfa::DecoratedXdgPopupWindow::draw_decorations(Buffer* buffer, Look const& look)
+{
+    if (look.id < 0) return;
+
+    auto const& config{look.config};
+    auto const x{config.stroke_width / 2};
+    auto const y{config.stroke_width / 2};
     auto const width{buffer->width - (x * 2)};
     auto const height{buffer->height - (y * 2)};
 
@@ -40,47 +53,47 @@ void mfa::DecoratedXdgPopupWindow::draw_new_content(Buffer* buffer)
         auto const pi{std::numbers::pi};
         auto const pi_2{pi / 2.0};
 
-        auto const tbi{std::max(config_.background_intensity - intensity_offset, 0.0)};
-        cairo_set_source_rgba(buffer->cairo_context, tbi, tbi, tbi, alpha);
-        cairo_set_line_width(buffer->cairo_context, config_.stroke_width);
+        auto const tbi{std::max(config.background_intensity - look.intensity_offset, 0.0)};
+        cairo_set_source_rgba(buffer->cairo_context, tbi, tbi, tbi, look.alpha);
+        cairo_set_line_width(buffer->cairo_context, config.stroke_width);
 
         cairo_new_sub_path(buffer->cairo_context);
         // Top-left corner
         cairo_arc(
             buffer->cairo_context,
-            x + config_.corner_radius,
-            y + config_.corner_radius,
-            config_.corner_radius,
+            x + config.corner_radius,
+            y + config.corner_radius,
+            config.corner_radius,
             pi,
             -pi_2);
         // Top-right corner
         cairo_arc(
             buffer->cairo_context,
-            x + width - config_.corner_radius,
-            y + config_.corner_radius,
-            config_.corner_radius,
+            x + width - config.corner_radius,
+            y + config.corner_radius,
+            config.corner_radius,
             -pi_2,
             0);
         // Bottom-right corner
         cairo_arc(
             buffer->cairo_context,
-            x + width - config_.corner_radius,
-            y + height - config_.corner_radius,
-            config_.corner_radius,
+            x + width - config.corner_radius,
+            y + height - config.corner_radius,
+            config.corner_radius,
             0,
             pi_2);
         // Bottom-left corner
         cairo_arc(
             buffer->cairo_context,
-            x + config_.corner_radius,
-            y + height - config_.corner_radius,
-            config_.corner_radius,
+            x + config.corner_radius,
+            y + height - config.corner_radius,
+            config.corner_radius,
             pi_2,
             pi);
         cairo_close_path(buffer->cairo_context);
         cairo_fill_preserve(buffer->cairo_context);
 
-        auto const si{config_.stroke_intensity};
+        auto const si{config.stroke_intensity};
         cairo_set_source_rgba(buffer->cairo_context, si, si, si, 1);
         cairo_stroke(buffer->cairo_context);
     }
@@ -102,15 +115,24 @@ void mfa::DecoratedXdgPopupWindow::draw_new_content(Buffer* buffer)
                 {
                     y_pos = padding - text_extents.y_bearing;
                 }
-                cairo_move_to(buffer->cairo_context, config().stroke_width + padding - text_extents.x_bearing, y_pos);
+                cairo_move_to(buffer->cairo_context, config.stroke_width + padding - text_extents.x_bearing, y_pos);
                 cairo_show_text(buffer->cairo_context, text.c_str());
                 y_pos += font_size * line_spacing;
             }};
 
-        print_line("ID: " + std::to_string(mir_window->id) + " - Parent ID: " + std::to_string(mir_window->parent->id));
+        print_line("ID: " + std::to_string(look.id) + " - Parent ID: " + std::to_string(look.parent_id));
     }
 }
 
+auto mfa::DecoratedXdgPopupWindow::shape() const -> Shape
+{
+    // The stroke is centered on the outline, so the painted corners extend half a stroke beyond the radius
+    return {
+        .top_corner_radius = config_.corner_radius + config_.stroke_width / 2,
+        .bottom_corner_radius = config_.corner_radius + config_.stroke_width / 2,
+        .translucent = alpha < 1};
+}
+
 void mfa::DecoratedXdgPopupWindow::show()
 {
     redraw();
@@ -25,17 +25,33 @@ public:
         xdg_positioner* positioner,
         Configuration config);
 
-    auto config() -> Configuration const& { return config_; }
+    auto config() const -> Configuration const& { return config_; }
 
 protected:
-    void draw_new_content(Buffer* buffer) override;
+    auto content_painter() const -> Painter override;
+
+    auto shape() const -> Shape override;
 
 private:
+    // What the popup looks like in a frame. It is copied into the painter of each frame, so the render thread never
+    // reads the window.
+    struct Look
+    {
+        Configuration config;
+        double alpha{};
+        double intensity_offset{};
+        // ID of the window, or -1 if it is not registered, in which case nothing is drawn
+        int id{-1};
+        int parent_id{-1};
+    };
+
     Configuration config_;
 
     double alpha{1};
     double intensity_offset{0.1};
 
+    static void draw_decorations(Buffer* buffer, Look const& look);
+
     void show() override;
 };
 }
@@ -1,26 +1,123 @@
 #include "decorated_xdg_toplevel_window.h"
 #include "globals.h"
 #include "mir_window.h"
+#include "xdg-shell.h"
 
 #include <cairo.h>
 #include <linux/input-event-codes.h>
+#include <wayland-client.h>
 
+#include <cmath>
 #include <functional>
 #include <numbers>
 #include <string>
+#include <utility>
+
+namespace
+{
+auto is_button(mir_flutter_app::HitRegion region) -> bool
+{
+    using mir_flutter_app::HitRegion;
+    return region == HitRegion::close_button ||
+           region == HitRegion::minimize_button ||
+           region == HitRegion::maximize_button;
+}
+}
 
 namespace mfa = mir_flutter_app;
 
+// The title bar as a synchronized subsurface stacked over the top of the window. It takes no input, so clicks
+// still reach the window surface underneath.
+class mfa::DecoratedXdgToplevelWindow::TitleBar : public Window
+{
+public:
+    TitleBar(DecoratedXdgToplevelWindow& owner, int32_t width, int32_t height) :
+        Window{wl_compositor_create_surface(Globals::instance().compositor()), width, height},
+        owner{owner},
+        subsurface{wl_subcompositor_get_subsurface(
+            Globals::instance().subcompositor(),
+            static_cast<wl_surface*>(*this),
+            static_cast<wl_surface*>(owner))}
+    {
+    }
+
+    ~TitleBar() override
+    {
+        wl_subsurface_destroy(subsurface);
+        wl_surface_destroy(static_cast<wl_surface*>(*this));
+    }
+
+    // Redraws only if the width, the activation state, the hovered button, or the corners changed since the last
+    // update
+    void update(int32_t width, Look const& look)
+    {
+        if (drawn &&
+            width == this->width() &&
+            look.intensity_offset == drawn_look.intensity_offset &&
+            look.hovered_button == drawn_look.hovered_button &&
+            look.corner_radius == drawn_look.corner_radius)
+        {
+            return;
+        }
+
+        resize(width, height());
+        if (look.corner_radius != drawn_look.corner_radius) update_shape();
+        drawn = true;
+        drawn_look = look;
+        commit_owner = true;
+        redraw();
+    }
+
+private:
+    DecoratedXdgToplevelWindow& owner;
+    wl_subsurface* subsurface;
+
+    bool drawn{};
+    Look drawn_look;
+    bool commit_owner{};
+
+    auto content_painter() const -> Painter override
+    {
+        return [look{drawn_look}](Buffer* buffer) { draw_title_bar(buffer, look); };
+    }
+
+    // The state of a synchronized subsurface is only applied when its parent commits, so the window is committed
+    // too unless a frame of its own, which applies it, is on the way
+    void handle_presented() override
+    {
+        if (std::exchange(commit_owner, false) && !owner.has_pending_frame())
+        {
+            wl_surface_commit(static_cast<wl_surface*>(owner));
+        }
+    }
+
+    auto shape() const -> Shape override
+    {
+        return {
+            .top_corner_radius = owner.outline_corner_radius(),
+            .translucent = owner.alpha < 1,
+            .accepts_input = false};
+    }
+};
+
 mfa::DecoratedXdgToplevelWindow::DecoratedXdgToplevelWindow(
     wl_surface* surface,
     int32_t width,
     int32_t height,
     Configuration config) :
     XdgToplevelWindow(surface, width, height),
-    config_{std::move(config)}
+    config_{std::move(config)},
+    current_corner_radius{config_.title_bar_corner_radius}
 {
+    if (config_.title_bar_on_subsurface && Globals::instance().subcompositor())
+    {
+        auto const title_bar_height{static_cast<int32_t>(std::ceil(config_.title_bar_height + config_.stroke_width))};
+        title_bar = std::make_unique<TitleBar>(*this, width, title_bar_height);
+    }
 }
 
+mfa::DecoratedXdgToplevelWindow::~DecoratedXdgToplevelWindow() = default;
+
 void mfa::DecoratedXdgToplevelWindow::handle_mouse_button(
     wl_pointer* pointer,
     uint32_t serial,
@@ -29,6 +126,36 @@ void mfa::DecoratedXdgToplevelWindow::handle_mouse_button(
     uint32_t state)
 {
     XdgToplevelWindow::handle_mouse_button(pointer, serial, time, button, state);
+    if (button != BTN_LEFT) return;
+
+    if (state == WL_POINTER_BUTTON_STATE_PRESSED)
+    {
+        pressed_button = is_button(hovered_region()) ? hovered_region() : HitRegion::none;
+        return;
+    }
+
+    // Buttons act when released, and only if the pointer is still over the one pressed
+    auto const clicked{std::exchange(pressed_button, HitRegion::none)};
+    if (clicked == HitRegion::none || clicked != hovered_region()) return;
+
+    if (clicked == HitRegion::minimize_button)
+    {
+        xdg_toplevel_set_minimized(static_cast<xdg_toplevel*>(*this));
+        return;
+    }
+
+    if (clicked == HitRegion::maximize_button)
+    {
+        if (is_maximized())
+        {
+            xdg_toplevel_unset_maximized(static_cast<xdg_toplevel*>(*this));
+        }
+        else
+        {
+            xdg_toplevel_set_maximized(static_cast<xdg_toplevel*>(*this));
+        }
+        return;
+    }
 
     // Prevent the window from being closed if it has a dialog descendant.
     //
@@ -63,133 +190,69 @@ void mfa::DecoratedXdgToplevelWindow::handle_mouse_button(
         return;
     }
 
-    auto const pointer_on_close_button{[this]
-        {
-            auto const margin{10};
-            auto const [x, y]{Globals::instance().pointer_position()};
-            return (x >= close_button_rect.left   - margin &&
-                    x <= close_button_rect.right  + margin &&
-                    y >= close_button_rect.top    - margin &&
-                    y <= close_button_rect.bottom + margin);
-        }};
-
-    if (button == BTN_LEFT)
-    {
-        if (state == WL_POINTER_BUTTON_STATE_PRESSED && pointer_on_close_button())
-        {
-            pressed_close_button = true;
-        }
+    Globals::instance().close_window(static_cast<wl_surface*>(*this));
+}
 
-        if (state == WL_POINTER_BUTTON_STATE_RELEASED)
+auto mfa::DecoratedXdgToplevelWindow::content_painter() const -> Painter
+{
+    return [look{look()}, with_title_bar{!title_bar}](Buffer* buffer)
         {
-            if (pressed_close_button && pointer_on_close_button())
-            {
-                Globals::instance().close_window(static_cast<wl_surface*>(*this));
-            }
+            draw_decorations(buffer, look, with_title_bar);
+        };
+}
 
-            pressed_close_button = false;
-        }
-    }
+auto mfa::DecoratedXdgToplevelWindow::look() const -> Look
+{
+    auto const* const mir_window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
+    return {
+        .config = config_,
+        .alpha = alpha,
+        .intensity_offset = current_intensity_offset,
+        .corner_radius = current_corner_radius,
+        .hovered_button = current_hovered_button,
+        .id = mir_window ? mir_window->id : -1,
+        .parent_id = mir_window && mir_window->parent ? mir_window->parent->id : -1};
 }
 
-void mfa::DecoratedXdgToplevelWindow::draw_new_content(Buffer* buffer)
+void mfa::DecoratedXdgToplevelWindow::draw_decorations(Buffer* buffer, Look const& look, bool with_title_bar)
 {
-    auto* mir_window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
-    if (!mir_window) return;
+    if (look.id < 0) return;
 
-    auto const x{config_.stroke_width / 2};
-    auto const y{config_.stroke_width / 2};
+    auto const& config{look.config};
+    auto const x{config.stroke_width / 2};
+    auto const y{config.stroke_width / 2};
     auto const width{buffer->width - (x * 2)};
     auto const height{buffer->height - (y * 2)};
 
-    auto const close_button_scale{0.25};
-    auto const pi{std::numbers::pi};
-    auto const pi_2{pi / 2.0};
-
     cairo_set_source_rgba(buffer->cairo_context, 0, 0, 0, 0);
     cairo_paint(buffer->cairo_context);
 
     // Title bar
+    if (with_title_bar)
     {
-        // Background
-        auto const tbi{std::max(config_.title_bar_intensity - current_intensity_offset, 0.0)};
-        cairo_set_source_rgba(buffer->cairo_context, tbi, tbi, tbi, alpha);
-        cairo_set_line_width(buffer->cairo_context, config_.stroke_width);
-
-        cairo_new_sub_path(buffer->cairo_context);
-        cairo_arc(buffer->cairo_context, x, y + config_.title_bar_height, 0, 0, 0);
-        cairo_arc(
-            buffer->cairo_context,
-            x + config_.title_bar_corner_radius,
-            y + config_.title_bar_corner_radius,
-            config_.title_bar_corner_radius,
-            pi,
-            -pi_2);
-        cairo_arc(
-            buffer->cairo_context,
-            x + width - config_.title_bar_corner_radius,
-            y + config_.title_bar_corner_radius,
-            config_.title_bar_corner_radius,
-            -pi_2,
-            0);
-        cairo_arc(buffer->cairo_context, x + width, y + config_.title_bar_height, 0, 0, 0);
-        cairo_fill_preserve(buffer->cairo_context);
-
-        auto const si{config_.stroke_intensity};
-        cairo_set_source_rgba(buffer->cairo_context, si, si, si, 1);
-        cairo_stroke(buffer->cairo_context);
-
-        // Text
-        cairo_set_source_rgb(buffer->cairo_context, 1, 1, 1);
-        cairo_select_font_face(buffer->cairo_context, "Ubuntu", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-        cairo_set_font_size(buffer->cairo_context, config_.title_bar_font_size);
-        auto title_text{config_.title_bar_text + " - ID " + std::to_string(mir_window->id)};
-        cairo_text_extents_t text_extents;
-        cairo_text_extents(buffer->cairo_context, title_text.c_str(), &text_extents);
-        cairo_move_to(
-            buffer->cairo_context,
-            (buffer->width - text_extents.width) / 2.0 - text_extents.x_bearing,
-            y + (config_.title_bar_height - text_extents.height) / 2.0 - text_extents.y_bearing);
-        cairo_show_text(buffer->cairo_context, title_text.c_str());
-
-        // Close button
-        auto const close_button_size{config_.title_bar_height * close_button_scale};
-        auto const close_button_padding{(config_.title_bar_height - close_button_size) / 2.0};
-        auto const left{x + width - close_button_padding - close_button_size};
-        auto const top{y + close_button_padding};
-        auto const right{left + close_button_size};
-        auto const bottom{top + close_button_size};
-        close_button_rect = {left, top, right, bottom};
-
-        cairo_set_source_rgb(buffer->cairo_context, 1, 1, 1);
-        cairo_set_line_width(buffer->cairo_context, 2);
-        cairo_move_to(buffer->cairo_context, left, top);
-        cairo_line_to(buffer->cairo_context, right, bottom);
-        cairo_move_to(buffer->cairo_context, right, top);
-        cairo_line_to(buffer->cairo_context, left, bottom);
-        cairo_stroke(buffer->cairo_context);
+        draw_title_bar(buffer, look);
     }
 
     // Client rectangle
     {
-        auto const bi{config_.background_intensity};
-        cairo_set_source_rgba(buffer->cairo_context, bi, bi, bi, alpha);
-        cairo_set_line_width(buffer->cairo_context, config_.stroke_width);
+        auto const bi{config.background_intensity};
+        cairo_set_source_rgba(buffer->cairo_context, bi, bi, bi, look.alpha);
+        cairo_set_line_width(buffer->cairo_context, config.stroke_width);
         cairo_rectangle(
             buffer->cairo_context,
             x,
-            y + config_.title_bar_height,
+            y + config.title_bar_height,
             width,
-            height - config_.title_bar_height);
+            height - config.title_bar_height);
         cairo_fill_preserve(buffer->cairo_context);
 
-        auto const si{config_.stroke_intensity};
+        auto const si{config.stroke_intensity};
         cairo_set_source_rgba(buffer->cairo_context, si, si, si, 1);
         cairo_stroke(buffer->cairo_context);
     }
 
     // Text
-    if (mir_window->parent)
+    if (look.parent_id >= 0)
     {
         auto const font_size{14};
         cairo_set_source_rgb(buffer->cairo_context, 0.2, 0.2, 0.2);
@@ -204,25 +267,230 @@ void mfa::DecoratedXdgToplevelWindow::draw_new_content(Buffer* buffer)
                 cairo_text_extents(buffer->cairo_context, text.c_str(), &text_extents);
                 if (y_pos == 0)
                 {
-                    y_pos = config().title_bar_height + padding - text_extents.y_bearing;
+                    y_pos = config.title_bar_height + padding - text_extents.y_bearing;
                 }
-                cairo_move_to(buffer->cairo_context, config().stroke_width + padding - text_extents.x_bearing, y_pos);
+                cairo_move_to(buffer->cairo_context, config.stroke_width + padding - text_extents.x_bearing, y_pos);
                 cairo_show_text(buffer->cairo_context, text.c_str());
                 y_pos += font_size * line_spacing;
             }};
 
-        print_line("Parent ID: " + std::to_string(mir_window->parent->id));
+        print_line("Parent ID: " + std::to_string(look.parent_id));
     }
 }
 
+void mfa::DecoratedXdgToplevelWindow::draw_title_bar(Buffer* buffer, Look const& look)
+{
+    if (look.id < 0) return;
+
+    auto const& config{look.config};
+    auto const x{config.stroke_width / 2};
+    auto const y{config.stroke_width / 2};
+    auto const width{buffer->width - (x * 2)};
+
+    auto const pi{std::numbers::pi};
+    auto const pi_2{pi / 2.0};
+
+    // Background
+    auto const tbi{std::max(config.title_bar_intensity - look.intensity_offset, 0.0)};
+    cairo_set_source_rgba(buffer->cairo_context, tbi, tbi, tbi, look.alpha);
+    cairo_set_line_width(buffer->cairo_context, config.stroke_width);
+
+    cairo_new_sub_path(buffer->cairo_context);
+    cairo_arc(buffer->cairo_context, x, y + config.title_bar_height, 0, 0, 0);
+    cairo_arc(
+        buffer->cairo_context,
+        x + look.corner_radius,
+        y + look.corner_radius,
+        look.corner_radius,
+        pi,
+        -pi_2);
+    cairo_arc(
+        buffer->cairo_context,
+        x + width - look.corner_radius,
+        y + look.corner_radius,
+        look.corner_radius,
+        -pi_2,
+        0);
+    cairo_arc(buffer->cairo_context, x + width, y + config.title_bar_height, 0, 0, 0);
+    cairo_fill_preserve(buffer->cairo_context);
+
+    auto const si{config.stroke_intensity};
+    cairo_set_source_rgba(buffer->cairo_context, si, si, si, 1);
+    cairo_stroke(buffer->cairo_context);
+
+    // Text
+    cairo_set_source_rgb(buffer->cairo_context, 1, 1, 1);
+    cairo_select_font_face(buffer->cairo_context, "Ubuntu", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(buffer->cairo_context, config.title_bar_font_size);
+    auto title_text{config.title_bar_text + " - ID " + std::to_string(look.id)};
+    cairo_text_extents_t text_extents;
+    cairo_text_extents(buffer->cairo_context, title_text.c_str(), &text_extents);
+    cairo_move_to(
+        buffer->cairo_context,
+        (buffer->width - text_extents.width) / 2.0 - text_extents.x_bearing,
+        y + (config.title_bar_height - text_extents.height) / 2.0 - text_extents.y_bearing);
+    cairo_show_text(buffer->cairo_context, title_text.c_str());
+
+    // Buttons
+    for (auto const button : {HitRegion::close_button, HitRegion::maximize_button, HitRegion::minimize_button})
+    {
+        auto const [left, top, right, bottom]{button_rect(config, button, buffer->width)};
+        if (right <= left) continue;
+
+        auto const center_x{(left + right) / 2.0};
+        auto const center_y{(top + bottom) / 2.0};
+        auto const glyph_scale{0.25};
+        auto const glyph_half_size{config.title_bar_height * glyph_scale / 2.0};
+
+        if (button == look.hovered_button)
+        {
+            auto const highlight_scale{0.35};
+            cairo_set_source_rgba(buffer->cairo_context, 1, 1, 1, 0.25);
+            cairo_new_sub_path(buffer->cairo_context);
+            cairo_arc(
+                buffer->cairo_context,
+                center_x,
+                center_y,
+                config.title_bar_height * highlight_scale,
+                0,
+                2 * pi);
+            cairo_fill(buffer->cairo_context);
+        }
+
+        cairo_set_source_rgb(buffer->cairo_context, 1, 1, 1);
+        cairo_set_line_width(buffer->cairo_context, 2);
+        if (button == HitRegion::close_button)
+        {
+            cairo_move_to(buffer->cairo_context, center_x - glyph_half_size, center_y - glyph_half_size);
+            cairo_line_to(buffer->cairo_context, center_x + glyph_half_size, center_y + glyph_half_size);
+            cairo_move_to(buffer->cairo_context, center_x + glyph_half_size, center_y - glyph_half_size);
+            cairo_line_to(buffer->cairo_context, center_x - glyph_half_size, center_y + glyph_half_size);
+        }
+        else if (button == HitRegion::maximize_button)
+        {
+            cairo_rectangle(
+                buffer->cairo_context,
+                center_x - glyph_half_size,
+                center_y - glyph_half_size,
+                glyph_half_size * 2,
+                glyph_half_size * 2);
+        }
+        else
+        {
+            cairo_move_to(buffer->cairo_context, center_x - glyph_half_size, center_y + glyph_half_size);
+            cairo_line_to(buffer->cairo_context, center_x + glyph_half_size, center_y + glyph_half_size);
+        }
+        cairo_stroke(buffer->cairo_context);
+    }
+}
+
+auto mfa::DecoratedXdgToplevelWindow::button_rect(Configuration const& config, HitRegion button, int32_t width)
+    -> Rectangle
+{
+    // Each button takes a square as tall as the title bar, laid out from the right: close, maximize, minimize
+    auto slot{0};
+    if (button == HitRegion::maximize_button)
+    {
+        if (!config.maximize_button) return {};
+        slot = 1;
+    }
+    else if (button == HitRegion::minimize_button)
+    {
+        if (!config.minimize_button) return {};
+        slot = config.maximize_button ? 2 : 1;
+    }
+    else if (button != HitRegion::close_button)
+    {
+        return {};
+    }
+
+    auto const right{width - config.stroke_width / 2 - slot * config.title_bar_height};
+    auto const top{config.stroke_width / 2};
+    return {right - config.title_bar_height, top, right, top + config.title_bar_height};
+}
+
+auto mfa::DecoratedXdgToplevelWindow::decoration_areas(int32_t width, int32_t /*height*/) const
+    -> std::vector<HitRegions::Area>
+{
+    std::vector<HitRegions::Area> areas{
+        {HitRegion::title_bar, 0, 0, static_cast<double>(width), config_.title_bar_height + config_.stroke_width}};
+
+    for (auto const button : {HitRegion::close_button, HitRegion::maximize_button, HitRegion::minimize_button})
+    {
+        auto const [left, top, right, bottom]{button_rect(config_, button, width)};
+        if (right > left)
+        {
+            areas.push_back({button, left, top, right, bottom});
+        }
+    }
+    return areas;
+}
+
+auto mfa::DecoratedXdgToplevelWindow::shape() const -> Shape
+{
+    return {
+        .top_corner_radius = outline_corner_radius(),
+        .translucent = alpha < 1};
+}
+
+auto mfa::DecoratedXdgToplevelWindow::outline_corner_radius() const -> double
+{
+    // The stroke is centered on the outline, so the painted corners extend half a stroke beyond the radius. Square
+    // corners leave nothing uncovered, so an opaque window can use XRGB8888 buffers.
+    return current_corner_radius > 0 ? current_corner_radius + config_.stroke_width / 2 : 0;
+}
+
+void mfa::DecoratedXdgToplevelWindow::update_corners()
+{
+    // Maximized windows meet the edges of the output, where rounded corners would show what is behind them
+    auto const corner_radius{is_maximized() ? 0 : config_.title_bar_corner_radius};
+    if (corner_radius == current_corner_radius) return;
+
+    current_corner_radius = corner_radius;
+    update_shape();
+}
+
+auto mfa::DecoratedXdgToplevelWindow::covered_height() const -> int32_t
+{
+    return title_bar ? title_bar->height() : 0;
+}
+
 void mfa::DecoratedXdgToplevelWindow::show_activated()
 {
     current_intensity_offset = intensity_offset;
+    update_corners();
+    if (title_bar)
+    {
+        title_bar->update(width(), look());
+    }
     redraw();
 }
 
 void mfa::DecoratedXdgToplevelWindow::show_unactivated()
 {
     current_intensity_offset = 0;
+    update_corners();
+    if (title_bar)
+    {
+        title_bar->update(width(), look());
+    }
     redraw();
 }
+
+void mfa::DecoratedXdgToplevelWindow::show_hovered()
+{
+    auto const hovered_button{is_button(hovered_region()) ? hovered_region() : HitRegion::none};
+    if (hovered_button == current_hovered_button) return;
+
+    current_hovered_button = hovered_button;
+
+    // Only the title bar changes, so its subsurface alone is redrawn if it has one
+    if (title_bar)
+    {
+        title_bar->update(width(), look());
+    }
+    else
+    {
+        redraw();
+    }
+}
@@ -3,6 +3,7 @@
 
 #include "xdg_toplevel_window.h"
 
+#include <memory>
 #include <string>
 
 namespace mir_flutter_app
@@ -19,22 +20,35 @@ public:
         double title_bar_intensity{0.4};
         double title_bar_height{36.0};
         double title_bar_font_size{16.0};
+        // Draws the title bar into a subsurface that is only redrawn when its own contents change
+        bool title_bar_on_subsurface{};
 
         double stroke_width{1.0};
         double stroke_intensity{0.2};
+
+        // Buttons shown on the title bar besides the close button
+        bool minimize_button{true};
+        bool maximize_button{true};
     };
 
     DecoratedXdgToplevelWindow(wl_surface* surface, int32_t width, int32_t height, Configuration config);
+    ~DecoratedXdgToplevelWindow() override;
 
-    auto config() -> Configuration const& { return config_; }
+    auto config() const -> Configuration const& { return config_; }
 
 protected:
     void handle_mouse_button(wl_pointer* pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state)
         override;
 
-    void draw_new_content(Buffer* buffer) override;
+    auto content_painter() const -> Painter override;
+
+    auto shape() const -> Shape override;
+    auto covered_height() const -> int32_t override;
+    auto decoration_areas(int32_t width, int32_t height) const -> std::vector<HitRegions::Area> override;
 
 private:
+    class TitleBar;
+
     struct Rectangle
     {
         double left{};
@@ -43,17 +57,46 @@ private:
         double bottom{};
     };
 
+    // What the decorations look like in a frame. It is copied into the painter of each frame, so the render thread
+    // never reads the window.
+    struct Look
+    {
+        Configuration config;
+        double alpha{};
+        double intensity_offset{};
+        double corner_radius{};
+        HitRegion hovered_button{};
+        // ID of the window, or -1 if it is not registered, in which case nothing is drawn
+        int id{-1};
+        // ID of the parent window, or -1 if there is none
+        int parent_id{-1};
+    };
+
     Configuration config_;
 
     double alpha{1};
     double intensity_offset{0.1};
     double current_intensity_offset{};
+    // Radius of the title bar corners as drawn, which is 0 while the window is maximized
+    double current_corner_radius{};
+    HitRegion current_hovered_button{};
+
+    HitRegion pressed_button{};
+
+    std::unique_ptr<TitleBar> title_bar;
 
-    Rectangle close_button_rect{};
-    bool pressed_close_button{};
+    auto look() const -> Look;
+    static void draw_decorations(Buffer* buffer, Look const& look, bool with_title_bar);
+    static void draw_title_bar(Buffer* buffer, Look const& look);
+    // Space a button takes on the title bar of a window of the given width, or an empty one if it is not shown
+    static auto button_rect(Configuration const& config, HitRegion button, int32_t width) -> Rectangle;
+    auto outline_corner_radius() const -> double;
+    // Squares the corners while the window is maximized, and rounds them again when it is restored
+    void update_corners();
 
     void show_activated() override;
     void show_unactivated() override;
+    void show_hovered() override;
 };
 }
 
@@ -8,7 +8,13 @@
 namespace mfa = mir_flutter_app;
 
 mfa::DialogWindow::DialogWindow(wl_surface* surface, int32_t width, int32_t height, xdg_toplevel* parent) :
-    DecoratedXdgToplevelWindow{surface, width, height, {.background_intensity = 0.95, .title_bar_text = "dialog"}},
+    DecoratedXdgToplevelWindow{surface, width, height,
+        {
+            .background_intensity = 0.95,
+            .title_bar_text = "dialog",
+            .minimize_button = false,
+            .maximize_button = false
+        }},
     mir_dialog_surface{
         Globals::instance().mir_shell() ?
         mir_shell_v1_get_dialog_surface(Globals::instance().mir_shell(), surface) :
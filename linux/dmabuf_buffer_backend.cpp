@@ -0,0 +1,198 @@
+#include "dmabuf_buffer_backend.h"
+#include "linux-dmabuf.h"
+
+#include <wayland-client.h>
+
+#include <fcntl.h>
+#include <linux/dma-buf.h>
+#include <linux/udmabuf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace
+{
+constexpr auto fourcc(char a, char b, char c, char d) -> uint32_t
+{
+    return static_cast<uint32_t>(a) |
+        static_cast<uint32_t>(b) << 8 |
+        static_cast<uint32_t>(c) << 16 |
+        static_cast<uint32_t>(d) << 24;
+}
+
+// wl_shm reuses the DRM fourcc codes for every format but the two mandatory ones
+auto drm_format(uint32_t shm_format) -> uint32_t
+{
+    switch (shm_format)
+    {
+    case WL_SHM_FORMAT_ARGB8888: return fourcc('A', 'R', '2', '4');
+    case WL_SHM_FORMAT_XRGB8888: return fourcc('X', 'R', '2', '4');
+    default: return shm_format;
+    }
+}
+
+// Importers commonly require row pitches aligned for their texture units
+int32_t const stride_alignment{256};
+}
+
+namespace mfa = mir_flutter_app;
+
+void mfa::DmabufBufferBackend::create(
+    zwp_linux_dmabuf_v1* linux_dmabuf,
+    std::set<uint32_t> linear_formats,
+    Created created)
+{
+    if (!linux_dmabuf || !linear_formats.contains(drm_format(WL_SHM_FORMAT_ARGB8888)))
+    {
+        created(nullptr);
+        return;
+    }
+
+    int const udmabuf_device{open("/dev/udmabuf", O_RDWR | O_CLOEXEC)};
+    if (udmabuf_device < 0)
+    {
+        created(nullptr);
+        return;
+    }
+
+    probe(
+        std::unique_ptr<DmabufBufferBackend>{
+            new DmabufBufferBackend{linux_dmabuf, udmabuf_device, std::move(linear_formats)}},
+        std::move(created));
+}
+
+mfa::DmabufBufferBackend::DmabufBufferBackend(
+    zwp_linux_dmabuf_v1* linux_dmabuf,
+    int udmabuf_device,
+    std::set<uint32_t> linear_formats) :
+    linux_dmabuf{linux_dmabuf},
+    udmabuf_device{udmabuf_device},
+    linear_formats{std::move(linear_formats)}
+{
+}
+
+mfa::DmabufBufferBackend::~DmabufBufferBackend()
+{
+    close(udmabuf_device);
+}
+
+auto mfa::DmabufBufferBackend::supports_format(uint32_t format) const -> bool
+{
+    return linear_formats.contains(drm_format(format));
+}
+
+auto mfa::DmabufBufferBackend::allocate(int32_t width, int32_t height, uint32_t format) -> Memory
+{
+    auto memory{map_udmabuf(width, height)};
+    if (memory.fd < 0) return {};
+
+    auto* const params{zwp_linux_dmabuf_v1_create_params(linux_dmabuf)};
+    zwp_linux_buffer_params_v1_add(params, memory.fd, 0, 0, memory.stride, 0, 0);
+    memory.buffer = zwp_linux_buffer_params_v1_create_immed(params, width, height, drm_format(format), 0);
+    zwp_linux_buffer_params_v1_destroy(params);
+
+    return memory;
+}
+
+void mfa::DmabufBufferBackend::destroy(Memory& memory)
+{
+    if (memory.buffer) wl_buffer_destroy(memory.buffer);
+    if (memory.data) munmap(memory.data, memory.size);
+    if (memory.fd >= 0) close(memory.fd);
+    memory = {};
+}
+
+void mfa::DmabufBufferBackend::begin_access(Memory const& memory)
+{
+    dma_buf_sync sync{.flags = DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE};
+    ioctl(memory.fd, DMA_BUF_IOCTL_SYNC, &sync);
+}
+
+void mfa::DmabufBufferBackend::end_access(Memory const& memory)
+{
+    dma_buf_sync sync{.flags = DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE};
+    ioctl(memory.fd, DMA_BUF_IOCTL_SYNC, &sync);
+}
+
+auto mfa::DmabufBufferBackend::map_udmabuf(int32_t width, int32_t height) -> Memory
+{
+    auto const stride{(width * 4 + stride_alignment - 1) / stride_alignment * stride_alignment};
+    auto const page_size{static_cast<size_t>(sysconf(_SC_PAGESIZE))};
+    auto const size{(static_cast<size_t>(stride) * height + page_size - 1) / page_size * page_size};
+
+    // udmabuf only accepts memfds that can no longer shrink
+    int const memfd{memfd_create("udmabuf", MFD_CLOEXEC | MFD_ALLOW_SEALING)};
+    if (memfd < 0) return {};
+
+    if (ftruncate(memfd, size) < 0 || fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK) < 0)
+    {
+        close(memfd);
+        return {};
+    }
+
+    udmabuf_create create{
+        .memfd = static_cast<__u32>(memfd),
+        .flags = UDMABUF_FLAGS_CLOEXEC,
+        .offset = 0,
+        .size = size};
+    int const dmabuf{ioctl(udmabuf_device, UDMABUF_CREATE, &create)};
+    close(memfd);
+    if (dmabuf < 0) return {};
+
+    auto* const data{mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, dmabuf, 0)};
+    if (data == MAP_FAILED)
+    {
+        close(dmabuf);
+        return {};
+    }
+
+    return {.data = data, .stride = stride, .size = size, .fd = dmabuf};
+}
+
+void mfa::DmabufBufferBackend::probe(std::unique_ptr<DmabufBufferBackend> backend, Created created)
+{
+    // Unlike create_immed, create reports import failures with an event rather than a fatal protocol error
+    struct Probe
+    {
+        std::unique_ptr<DmabufBufferBackend> backend;
+        Memory memory;
+        Created created;
+
+        void finish(zwp_linux_buffer_params_v1* params, bool imported)
+        {
+            zwp_linux_buffer_params_v1_destroy(params);
+            backend->destroy(memory);
+            created(imported ? std::move(backend) : nullptr);
+        }
+    };
+
+    static zwp_linux_buffer_params_v1_listener const params_listener{
+        .created = [](void* ctx, zwp_linux_buffer_params_v1* params, wl_buffer* buffer)
+            {
+                std::unique_ptr<Probe> const probe{static_cast<Probe*>(ctx)};
+                wl_buffer_destroy(buffer);
+                probe->finish(params, true);
+            },
+        .failed = [](void* ctx, zwp_linux_buffer_params_v1* params)
+            {
+                std::unique_ptr<Probe> const probe{static_cast<Probe*>(ctx)};
+                probe->finish(params, false);
+            }};
+
+    auto memory{backend->map_udmabuf(1, 1)};
+    if (memory.fd < 0)
+    {
+        created(nullptr);
+        return;
+    }
+
+    auto* const params{zwp_linux_dmabuf_v1_create_params(backend->linux_dmabuf)};
+    zwp_linux_buffer_params_v1_add(params, memory.fd, 0, 0, memory.stride, 0, 0);
+    zwp_linux_buffer_params_v1_add_listener(
+        params,
+        &params_listener,
+        new Probe{.backend = std::move(backend), .memory = memory, .created = std::move(created)});
+    zwp_linux_buffer_params_v1_create(params, 1, 1, drm_format(WL_SHM_FORMAT_ARGB8888), 0);
+}
@@ -0,0 +1,50 @@
+#ifndef DMABUF_BUFFER_BACKEND_H_
+#define DMABUF_BUFFER_BACKEND_H_
+
+#include "buffer_backend.h"
+
+#include <functional>
+#include <memory>
+#include <set>
+
+struct zwp_linux_dmabuf_v1;
+
+namespace mir_flutter_app
+{
+// Shares buffers with the compositor as dmabufs carved out of memfds through udmabuf, so no GPU is needed on
+// the client side and the compositor can import them without copying.
+class DmabufBufferBackend : public BufferBackend
+{
+public:
+    using Created = std::function<void(std::unique_ptr<DmabufBufferBackend> backend)>;
+
+    // Passes nullptr to created if udmabuf is unavailable or the compositor fails to import a probe buffer.
+    // linear_formats are the DRM formats the compositor advertised with the linear modifier. The probe is answered
+    // from the event queue, so created is called from it, or right away if there is nothing to probe.
+    static void create(zwp_linux_dmabuf_v1* linux_dmabuf, std::set<uint32_t> linear_formats, Created created);
+    ~DmabufBufferBackend() override;
+
+    auto supports_format(uint32_t format) const -> bool override;
+    auto allocate(int32_t width, int32_t height, uint32_t format) -> Memory override;
+    void destroy(Memory& memory) override;
+
+    void begin_access(Memory const& memory) override;
+    void end_access(Memory const& memory) override;
+
+private:
+    DmabufBufferBackend(zwp_linux_dmabuf_v1* linux_dmabuf, int udmabuf_device, std::set<uint32_t> linear_formats);
+
+    zwp_linux_dmabuf_v1* linux_dmabuf;
+    int udmabuf_device;
+    std::set<uint32_t> linear_formats;
+
+    auto map_udmabuf(int32_t width, int32_t height) -> Memory;
+    // Asks the compositor to import a small buffer and hands the backend to created if it does
+    static void probe(std::unique_ptr<DmabufBufferBackend> backend, Created created);
+
+    DmabufBufferBackend(DmabufBufferBackend const&) = delete;
+    DmabufBufferBackend& operator=(DmabufBufferBackend const&) = delete;
+};
+}
+
+#endif // DMABUF_BUFFER_BACKEND_H_
@@ -0,0 +1,37 @@
+#include "event_recorder.h"
+#include "logger.h"
+
+#include <cstdlib>
+
+namespace mfa = mir_flutter_app;
+
+mfa::EventRecorder::EventRecorder()
+{
+    auto const* const path{std::getenv("MIR_FLUTTER_APP_RECORD")};
+    if (!path) return;
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        MFA_LOG(warning, "recorder", "Failed to open event recording file ", path);
+        return;
+    }
+
+    file.write(magic.data(), magic.size());
+    file.write(reinterpret_cast<char const*>(&version), sizeof(version));
+    start = std::chrono::steady_clock::now();
+}
+
+void mfa::EventRecorder::write(Kind kind, int32_t window_id, std::array<uint32_t, 4> const& args)
+{
+    Event const event{
+        .time_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()),
+        .kind = kind,
+        .padding = {},
+        .window_id = window_id,
+        .args = args};
+
+    // Buffered by the stream and flushed when it is closed at exit
+    file.write(reinterpret_cast<char const*>(&event), sizeof(event));
+}
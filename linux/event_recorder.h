@@ -0,0 +1,85 @@
+#ifndef EVENT_RECORDER_H_
+#define EVENT_RECORDER_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+
+namespace mir_flutter_app
+{
+// Records the Wayland events reaching Globals and the shell listeners to a compact binary file, so event
+// sequences hit in the field can be inspected and replayed. Recording is enabled by setting
+// MIR_FLUTTER_APP_RECORD to the path of the file to write.
+class EventRecorder
+{
+public:
+    enum class Kind : uint8_t
+    {
+        pointer_enter,          // x, y (wl_fixed_t)
+        pointer_leave,
+        pointer_motion,         // time, x, y
+        pointer_button,         // serial, time, button, state
+        keyboard_enter,
+        keyboard_leave,
+        keyboard_key,           // serial, time, key, state
+        keyboard_modifiers,     // depressed, latched, locked, group
+        toplevel_configure,     // width, height, states (a set of the *_state bits below)
+        surface_configure,      // serial
+        popup_configure,        // x, y, width, height
+        repositioned,           // token
+    };
+
+    // Fixed-size record, written as is
+    struct Event
+    {
+        uint64_t time_us;       // Since recording started
+        Kind kind;
+        uint8_t padding[3];
+        int32_t window_id;      // -1 for surfaces that are not a MirWindow, such as the main window
+        std::array<uint32_t, 4> args;
+    };
+    static_assert(sizeof(Event) == 32);
+
+    // Bits of the states of toplevel_configure
+    static uint32_t const activated_state{1u << 0};
+    static uint32_t const suspended_state{1u << 1};
+    static uint32_t const maximized_state{1u << 2};
+
+    static constexpr std::array<char, 4> magic{'M', 'F', 'A', 'E'};
+    static uint32_t const version{1};
+
+    EventRecorder(EventRecorder const&) = delete;
+    EventRecorder(EventRecorder&&) = delete;
+    EventRecorder& operator=(EventRecorder const&) = delete;
+    EventRecorder& operator=(EventRecorder&&) = delete;
+    ~EventRecorder() = default;
+
+    static EventRecorder& instance()
+    {
+        static EventRecorder instance;
+        return instance;
+    }
+
+    auto enabled() const -> bool { return file.is_open(); }
+
+    // Stops recording while events are replayed, so a replay does not record its own events
+    void set_paused(bool paused) { this->paused = paused; }
+
+    void record(Kind kind, int32_t window_id, std::array<uint32_t, 4> args = {})
+    {
+        if (enabled() && !paused) write(kind, window_id, args);
+    }
+
+private:
+    std::ofstream file;
+    bool paused{};
+    std::chrono::steady_clock::time_point start;
+
+    void write(Kind kind, int32_t window_id, std::array<uint32_t, 4> const& args);
+
+    EventRecorder();
+};
+}
+
+#endif // EVENT_RECORDER_H_
@@ -0,0 +1,160 @@
+#include "event_replayer.h"
+#include "globals.h"
+#include "logger.h"
+#include "mir_window.h"
+#include "xdg_popup_window.h"
+#include "xdg_toplevel_window.h"
+
+#include <glib.h>
+
+#include <fstream>
+
+namespace mfa = mir_flutter_app;
+
+namespace
+{
+// Replays in progress, as more than one recording can be replayed at once
+int active_replays{};
+}
+
+auto mfa::EventReplayer::start(std::string const& path) -> bool
+{
+    std::ifstream file{path, std::ios::binary};
+
+    std::array<char, 4> magic;
+    uint32_t version{};
+    file.read(magic.data(), magic.size());
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || magic != EventRecorder::magic || version != EventRecorder::version)
+    {
+        MFA_LOG(warning, "replayer", "Not an event recording: ", path.c_str());
+        return false;
+    }
+
+    std::vector<EventRecorder::Event> events;
+    EventRecorder::Event event;
+    while (file.read(reinterpret_cast<char*>(&event), sizeof(event)))
+    {
+        if (event.kind != EventRecorder::Kind::repositioned)
+        {
+            events.push_back(event);
+        }
+    }
+
+    MFA_LOG(info, "replayer", "Replaying ", events.size(), " events from ", path.c_str());
+
+    // Deletes itself once every event is replayed
+    (new EventReplayer{std::move(events)})->schedule_next();
+    return true;
+}
+
+auto mfa::EventReplayer::replaying() -> bool
+{
+    return active_replays > 0;
+}
+
+mfa::EventReplayer::EventReplayer(std::vector<EventRecorder::Event> events) :
+    events{std::move(events)}
+{
+    ++active_replays;
+    EventRecorder::instance().set_paused(true);
+}
+
+mfa::EventReplayer::~EventReplayer()
+{
+    if (--active_replays == 0)
+    {
+        EventRecorder::instance().set_paused(false);
+    }
+}
+
+void mfa::EventReplayer::schedule_next()
+{
+    if (next == events.size())
+    {
+        delete this;
+        return;
+    }
+
+    auto const delay_us{next == 0 ? 0 : events[next].time_us - events[next - 1].time_us};
+    g_timeout_add(
+        static_cast<guint>(delay_us / 1000),
+        [](gpointer ctx) -> gboolean
+        {
+            auto* const self{static_cast<EventReplayer*>(ctx)};
+            self->replay_next();
+            self->schedule_next();
+            return G_SOURCE_REMOVE;
+        },
+        this);
+}
+
+void mfa::EventReplayer::replay_next()
+{
+    using Kind = EventRecorder::Kind;
+
+    auto const& event{events[next++]};
+    auto& globals{Globals::instance()};
+
+    wl_surface* surface{};
+    MirWindow* window{};
+    for (auto const& [window_surface, mir_window] : globals.windows)
+    {
+        if (mir_window->id == event.window_id)
+        {
+            surface = window_surface;
+            window = mir_window;
+        }
+    }
+
+    // Skip events for windows that do not exist in this session
+    if (!surface && event.window_id >= 0) return;
+
+    auto* const toplevel{window && std::holds_alternative<std::unique_ptr<XdgToplevelWindow>>(window->window)
+        ? std::get<std::unique_ptr<XdgToplevelWindow>>(window->window).get()
+        : nullptr};
+    auto* const popup{window && std::holds_alternative<std::unique_ptr<XdgPopupWindow>>(window->window)
+        ? std::get<std::unique_ptr<XdgPopupWindow>>(window->window).get()
+        : nullptr};
+
+    auto const [a, b, c, d]{event.args};
+    switch (event.kind)
+    {
+        case Kind::pointer_enter:
+            globals.handle_mouse_enter(globals.pointer, 0, surface, static_cast<int32_t>(a), static_cast<int32_t>(b));
+            break;
+        case Kind::pointer_leave:
+            globals.handle_mouse_leave(globals.pointer, 0, surface);
+            break;
+        case Kind::pointer_motion:
+            globals.handle_mouse_motion(globals.pointer, a, static_cast<int32_t>(b), static_cast<int32_t>(c));
+            break;
+        case Kind::pointer_button:
+            globals.handle_mouse_button(globals.pointer, a, b, c, d);
+            break;
+        case Kind::keyboard_enter:
+            globals.handle_keyboard_enter(globals.keyboard, 0, surface, nullptr);
+            break;
+        case Kind::keyboard_leave:
+            globals.handle_keyboard_leave(globals.keyboard, 0, surface);
+            break;
+        case Kind::keyboard_key:
+            globals.handle_keyboard_key(globals.keyboard, a, b, c, d);
+            break;
+        case Kind::keyboard_modifiers:
+            globals.handle_keyboard_modifiers(globals.keyboard, 0, a, b, c, d);
+            break;
+        case Kind::toplevel_configure:
+            if (toplevel) toplevel->replay_toplevel_configure(static_cast<int32_t>(a), static_cast<int32_t>(b), c);
+            break;
+        case Kind::popup_configure:
+            if (popup) popup->replay_popup_configure(static_cast<int32_t>(c), static_cast<int32_t>(d));
+            break;
+        case Kind::surface_configure:
+            if (toplevel) toplevel->replay_surface_configure();
+            if (popup) popup->replay_surface_configure();
+            break;
+        default:
+            break;
+    }
+}
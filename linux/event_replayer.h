@@ -0,0 +1,42 @@
+#ifndef EVENT_REPLAYER_H_
+#define EVENT_REPLAYER_H_
+
+#include "event_recorder.h"
+
+#include <string>
+#include <vector>
+
+namespace mir_flutter_app
+{
+// Feeds the events of a recording made by EventRecorder back into the Globals handlers and the windows, with their
+// original timing. Events are sent to the windows that currently have the recorded IDs. Nothing is recorded while
+// a recording is replayed.
+//
+// Configure events are applied without being acknowledged, as acknowledging serials that the compositor never sent
+// is a protocol error. For the same reason, replayed presses do not start moves or resizes. Repositioned events
+// are not replayed: their tokens belong to the recorded session, and the configures that follow them are.
+class EventReplayer
+{
+public:
+    // Returns false if the file is not a recording this version can read
+    static auto start(std::string const& path) -> bool;
+
+    // Whether a recording is being replayed
+    static auto replaying() -> bool;
+
+    EventReplayer(EventReplayer const&) = delete;
+    EventReplayer& operator=(EventReplayer const&) = delete;
+    ~EventReplayer();
+
+private:
+    std::vector<EventRecorder::Event> events;
+    size_t next{};
+
+    explicit EventReplayer(std::vector<EventRecorder::Event> events);
+
+    void replay_next();
+    void schedule_next();
+};
+}
+
+#endif // EVENT_REPLAYER_H_
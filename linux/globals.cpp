@@ -1,4 +1,6 @@
 #include "globals.h"
+#include "dmabuf_buffer_backend.h"
+#include "shm_buffer_backend.h"
 #include "xdg_toplevel_window.h"
 #include "xdg_popup_window.h"
 #include "regular_window.h"
@@ -7,14 +9,114 @@
 #include "satellite_window.h"
 #include "popup_window.h"
 #include "tip_window.h"
+#include "window_pool.h"
+#include "event_recorder.h"
+#include "logger.h"
+#include "memory_budget.h"
+#include "render_thread.h"
+#include "stats.h"
+#include "tile_renderer.h"
+#include "tracer.h"
 #include "mir_window.h"
 #include "xdg-shell.h"
 #include "mir-shell.h"
+#include "linux-dmabuf.h"
 
-#include <iomanip>
-#include <iostream>
+#include <glib.h>
+#include <cairo.h>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <utility>
 #include <vector>
 
+namespace
+{
+// Dispatches the runner's event queue from the GLib main loop. GDK already reads the display socket on behalf of
+// every queue, so this source only dispatches the events it queued for us.
+struct EventQueueSource
+{
+    GSource source;
+    wl_display* display;
+    wl_event_queue* queue;
+};
+
+auto has_pending_events(GSource* source) -> bool
+{
+    auto* const self{reinterpret_cast<EventQueueSource*>(source)};
+
+    // A read is only prepared if the queue is empty, so cancel it straight away as GDK does the reading
+    if (wl_display_prepare_read_queue(self->display, self->queue) != 0) return true;
+    wl_display_cancel_read(self->display);
+    return false;
+}
+
+GSourceFuncs event_queue_source_funcs{
+    .prepare = [](GSource* source, gint* timeout) -> gboolean
+        {
+            wl_display_flush(reinterpret_cast<EventQueueSource*>(source)->display);
+            *timeout = -1;
+            return has_pending_events(source);
+        },
+    .check = [](GSource* source) -> gboolean { return has_pending_events(source); },
+    .dispatch = [](GSource* source, GSourceFunc, gpointer) -> gboolean
+        {
+            auto* const self{reinterpret_cast<EventQueueSource*>(source)};
+            wl_display_dispatch_queue_pending(self->display, self->queue);
+            return G_SOURCE_CONTINUE;
+        },
+    .finalize = nullptr};
+
+auto window_name(MirWindow* window) -> std::string
+{
+    return window ? "Window " + std::to_string(window->id) : "Main window";
+}
+
+auto window_id(MirWindow* window) -> int32_t
+{
+    return window ? window->id : -1;
+}
+
+auto parent_xdg_surface(MirWindow* window) -> xdg_surface*
+{
+    return std::visit(
+        [](auto const& parent) { return static_cast<xdg_surface*>(*parent); },
+        window->parent->window);
+}
+
+auto positioner_key(MirWindowPositioner const& positioner, MirWindowSize const& size)
+    -> mir_flutter_app::PositionerKey
+{
+    return {
+        positioner.anchor_rect.x,
+        positioner.anchor_rect.y,
+        positioner.anchor_rect.width,
+        positioner.anchor_rect.height,
+        positioner.anchor,
+        positioner.gravity,
+        positioner.offset.dx,
+        positioner.offset.dy,
+        positioner.constraint_adjustment,
+        size.width,
+        size.height};
+}
+
+// Calls then once the server has processed every request sent so far on the display's queue
+void after_sync(wl_display* display, std::function<void()> then)
+{
+    static wl_callback_listener const callback_listener{
+        .done = [](void* ctx, wl_callback* callback, uint32_t /*callback_data*/)
+            {
+                std::unique_ptr<std::function<void()>> const then{static_cast<std::function<void()>*>(ctx)};
+                wl_callback_destroy(callback);
+                (*then)();
+            }};
+
+    wl_callback_add_listener(wl_display_sync(display), &callback_listener, new std::function<void()>{std::move(then)});
+}
+}
+
 namespace mfa = mir_flutter_app;
 
 void mfa::Globals::bind_interfaces(wl_display* wl_display)
@@ -24,11 +126,87 @@ void mfa::Globals::bind_interfaces(wl_display* wl_display)
         return;
     }
     display_ = wl_display;
+    bind_started = std::chrono::steady_clock::now();
+    Tracer::instance().begin_async("bind globals");
 
     static wl_registry_listener const registry_listener{
         .global = [](void* ctx, auto... args) { static_cast<Globals*>(ctx)->handle_wl_registry_global(args...); },
         .global_remove = [](auto...) {}};
 
+    // Objects created from the registry inherit its queue, keeping the runner's input, shell and buffer events
+    // separate from GDK's
+    event_queue_ = wl_display_create_queue(display());
+    display_wrapper = static_cast<::wl_display*>(wl_proxy_create_wrapper(display()));
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(display_wrapper), event_queue_);
+    wl_registry* const registry{wl_display_get_registry(display_wrapper)};
+    if (!registry)
+    {
+        MFA_LOG(error, "globals", "Failed to retrieve registry from the Wayland display connection");
+        std::abort();
+    }
+
+    auto* const source{g_source_new(&event_queue_source_funcs, sizeof(EventQueueSource))};
+    reinterpret_cast<EventQueueSource*>(source)->display = display();
+    reinterpret_cast<EventQueueSource*>(source)->queue = event_queue_;
+    g_source_set_name(source, "mir_flutter_app event queue");
+    g_source_attach(source, nullptr);
+    g_source_unref(source);
+
+    // Binding completes from the main loop while the Flutter engine starts
+    wl_registry_add_listener(registry, &registry_listener, this);
+    after_sync(display_wrapper, [this] { handle_globals_bound(); });
+}
+
+void mfa::Globals::when_ready(std::function<void()> callback)
+{
+    if (ready)
+    {
+        callback();
+    }
+    else
+    {
+        waiting_for_ready.push_back(std::move(callback));
+    }
+}
+
+void mfa::Globals::prewarm()
+{
+    Tracer::instance().begin("prewarm");
+    auto const started{std::chrono::steady_clock::now()};
+
+    // Loads the font face and glyphs of the sizes used by the title bars and window contents
+    auto* const cairo_surface{cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1)};
+    auto* const cairo_context{cairo_create(cairo_surface)};
+    cairo_select_font_face(cairo_context, "Ubuntu", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    for (auto const size : {13, 14, 24})
+    {
+        cairo_set_font_size(cairo_context, size);
+        cairo_move_to(cairo_context, 0, 0);
+        cairo_show_text(cairo_context, "Regular Floating Dialog Satellite Popup Tip 0123456789");
+    }
+    cairo_destroy(cairo_context);
+    cairo_surface_destroy(cairo_surface);
+
+    RenderThread::instance();
+    TileRenderer::instance();
+
+    // A small buffer makes the backend set up its first pool
+    auto memory{buffer_backend_->allocate(16, 16, WL_SHM_FORMAT_ARGB8888)};
+    if (memory.buffer) buffer_backend_->destroy(memory);
+
+    // Never given a role, so it is never shown
+    auto* const surface{wl_compositor_create_surface(compositor_)};
+    auto* const shell_surface{xdg_wm_base_get_xdg_surface(wm_base_, surface)};
+    xdg_surface_destroy(shell_surface);
+    wl_surface_destroy(surface);
+
+    Tracer::instance().end("prewarm");
+    std::chrono::duration<double, std::milli> const duration{std::chrono::steady_clock::now() - started};
+    MFA_LOG(info, "globals", "Prewarmed in ", duration.count(), " ms");
+}
+
+void mfa::Globals::handle_globals_bound()
+{
     static xdg_wm_base_listener const shell_listener{
         .ping = [](void*, xdg_wm_base* shell, uint32_t serial) { xdg_wm_base_pong(shell, serial); }};
 
@@ -47,41 +225,33 @@ void mfa::Globals::bind_interfaces(wl_display* wl_display)
         .modifiers = [](void* self, auto... args) { static_cast<Globals*>(self)->handle_keyboard_modifiers(args...); },
         .repeat_info = [](auto...) {}};
 
-
-    wl_registry* const registry{wl_display_get_registry(display())};
-    if (!registry)
-    {
-        std::cerr << "Failed to retrieve registry from the Wayland display connection.\n";
-        std::abort();
-    }
-
-    wl_registry_add_listener(registry, &registry_listener, this);
-    wl_display_roundtrip(display());
+    globals_bound = std::chrono::steady_clock::now();
+    Tracer::instance().instant("globals bound");
 
     bool failed_binding{};
     if (!output_)
     {
-        std::cerr << "Failed to bind to wl_output.\n";
+        MFA_LOG(error, "globals", "Failed to bind to wl_output");
         failed_binding = true;
     }
     if (!seat_)
     {
-        std::cerr << "Failed to bind to wl_seat.\n";
+        MFA_LOG(error, "globals", "Failed to bind to wl_seat");
         failed_binding = true;
     }
     if (!shm_)
     {
-        std::cerr << "Failed to bind to wl_shm.\n";
+        MFA_LOG(error, "globals", "Failed to bind to wl_shm");
         failed_binding = true;
     }
     if (!wm_base_)
     {
-        std::cerr << "Failed to bind to wm_base.\n";
+        MFA_LOG(error, "globals", "Failed to bind to wm_base");
         failed_binding = true;
     }
     if (!mir_shell_)
     {
-        std::cerr << "Failed to bind to mir_shell.\n";
+        MFA_LOG(error, "globals", "Failed to bind to mir_shell");
         failed_binding = true;
     }
 
@@ -91,12 +261,54 @@ void mfa::Globals::bind_interfaces(wl_display* wl_display)
     }
 
     xdg_wm_base_add_listener(wm_base(), &shell_listener, nullptr);
-    wl_display_roundtrip(display());
 
     pointer = wl_seat_get_pointer(seat_);
     keyboard = wl_seat_get_keyboard(seat_);
     wl_keyboard_add_listener(keyboard, &keyboard_listener, this);
     wl_pointer_add_listener(pointer, &pointer_listener, this);
+
+    // The shm and dmabuf formats are sent in response to binding, so they have all arrived once this sync is done
+    after_sync(display_wrapper, [this] { handle_formats_received(); });
+}
+
+void mfa::Globals::handle_formats_received()
+{
+    wl_proxy_wrapper_destroy(display_wrapper);
+    display_wrapper = nullptr;
+
+    // The dmabuf backend is only chosen once the compositor has answered its probe, without blocking the main loop
+    DmabufBufferBackend::create(
+        linux_dmabuf,
+        std::move(dmabuf_linear_formats),
+        [this](std::unique_ptr<DmabufBufferBackend> backend) { handle_buffer_backend_chosen(std::move(backend)); });
+}
+
+void mfa::Globals::handle_buffer_backend_chosen(std::unique_ptr<BufferBackend> backend)
+{
+    if (backend)
+    {
+        MFA_LOG(info, "globals", "Using udmabuf-backed dmabuf buffers");
+        buffer_backend_ = std::move(backend);
+    }
+    else
+    {
+        buffer_backend_ = std::make_unique<ShmBufferBackend>(shm_);
+    }
+
+    auto const milliseconds{[](auto duration)
+        { return std::chrono::duration<double, std::milli>(duration).count(); }};
+    auto const now{std::chrono::steady_clock::now()};
+    MFA_LOG(info, "globals", "Wayland globals ready in ", milliseconds(now - bind_started), " ms (binding: ",
+        milliseconds(globals_bound - bind_started), " ms, formats and buffer backend: ",
+        milliseconds(now - globals_bound), " ms)");
+
+    Tracer::instance().end_async("bind globals");
+
+    ready = true;
+    for (auto const& callback : std::exchange(waiting_for_ready, {}))
+    {
+        callback();
+    }
 }
 
 auto mfa::Globals::make_regular_window(MirWindow* window) -> std::unique_ptr<XdgToplevelWindow>
@@ -119,58 +331,80 @@ auto mfa::Globals::make_satellite_window(MirWindow* window) -> std::unique_ptr<X
 
     if (!window->parent)
     {
-        std::cerr << "Satellite window must have a parent.\n";
+        MFA_LOG(error, "globals", "Satellite window must have a parent");
         std::abort();
     }
 
-    auto* const positioner{mir_shell_v1_create_positioner(mir_shell_)};
-    mir_positioner_v1_set_anchor_rect(
-        positioner,
-        window->positioner.anchor_rect.x,
-        window->positioner.anchor_rect.y,
-        window->positioner.anchor_rect.width,
-        window->positioner.anchor_rect.height);
-    mir_positioner_v1_set_anchor(positioner, window->positioner.anchor);
-    mir_positioner_v1_set_gravity(positioner, window->positioner.gravity);
-    mir_positioner_v1_set_offset(positioner, window->positioner.offset.dx, window->positioner.offset.dy);
-    mir_positioner_v1_set_constraint_adjustment(positioner, window->positioner.constraint_adjustment);
-
     auto* const parent{static_cast<xdg_toplevel*>(
         *std::get<std::unique_ptr<mfa::XdgToplevelWindow>>(window->parent->window))};
     return std::make_unique<SatelliteWindow>(
         window->surface,
         window->size.width,
         window->size.height,
-        positioner,
+        mir_positioner_for(window->positioner),
         parent);
 }
 
+auto mfa::Globals::mir_positioner_for(MirWindowPositioner const& positioner) -> mir_positioner_v1*
+{
+    // Satellites are sized by the compositor, so the size does not matter
+    return mir_positioners.get(
+        positioner_key(positioner, {}),
+        [this, &positioner]
+        {
+            auto* const new_positioner{mir_shell_v1_create_positioner(mir_shell_)};
+            mir_positioner_v1_set_anchor_rect(
+                new_positioner,
+                positioner.anchor_rect.x,
+                positioner.anchor_rect.y,
+                positioner.anchor_rect.width,
+                positioner.anchor_rect.height);
+            mir_positioner_v1_set_anchor(new_positioner, positioner.anchor);
+            mir_positioner_v1_set_gravity(new_positioner, positioner.gravity);
+            mir_positioner_v1_set_offset(new_positioner, positioner.offset.dx, positioner.offset.dy);
+            mir_positioner_v1_set_constraint_adjustment(new_positioner, positioner.constraint_adjustment);
+            return new_positioner;
+        },
+        mir_positioner_v1_destroy);
+}
+
+auto mfa::Globals::xdg_positioner_for(MirWindowPositioner const& positioner, MirWindowSize const& size)
+    -> xdg_positioner*
+{
+    return xdg_positioners.get(
+        positioner_key(positioner, size),
+        [this, &positioner, &size]
+        {
+            auto* const new_positioner{xdg_wm_base_create_positioner(wm_base_)};
+            xdg_positioner_set_size(new_positioner, size.width, size.height);
+            xdg_positioner_set_anchor_rect(
+                new_positioner,
+                positioner.anchor_rect.x,
+                positioner.anchor_rect.y,
+                positioner.anchor_rect.width,
+                positioner.anchor_rect.height);
+            xdg_positioner_set_anchor(new_positioner, positioner.anchor);
+            xdg_positioner_set_gravity(new_positioner, positioner.gravity);
+            xdg_positioner_set_constraint_adjustment(new_positioner, positioner.constraint_adjustment);
+            xdg_positioner_set_offset(new_positioner, positioner.offset.dx, positioner.offset.dy);
+            return new_positioner;
+        },
+        xdg_positioner_destroy);
+}
+
 auto mfa::Globals::make_popup_window(MirWindow* window) -> std::unique_ptr<XdgPopupWindow>
 {
     register_window(window);
 
     if (!window->parent)
     {
-        std::cerr << "Poup window must have a parent.\n";
+        MFA_LOG(error, "globals", "Poup window must have a parent");
         std::abort();
     }
 
-    auto* const parent{std::holds_alternative<std::unique_ptr<mfa::XdgToplevelWindow>>(window->parent->window) ?
-        static_cast<xdg_surface*>(*std::get<std::unique_ptr<mfa::XdgToplevelWindow>>(window->parent->window)) :
-        static_cast<xdg_surface*>(*std::get<std::unique_ptr<mfa::XdgPopupWindow>>(window->parent->window))};
+    auto* const parent{parent_xdg_surface(window)};
 
-    auto* const positioner{xdg_wm_base_create_positioner(wm_base_)};
-    xdg_positioner_set_size(positioner, window->size.width, window->size.height);
-    xdg_positioner_set_anchor_rect(
-        positioner,
-        window->positioner.anchor_rect.x,
-        window->positioner.anchor_rect.y,
-        window->positioner.anchor_rect.width,
-        window->positioner.anchor_rect.height);
-    xdg_positioner_set_anchor(positioner, window->positioner.anchor);
-    xdg_positioner_set_gravity(positioner, window->positioner.gravity);
-    xdg_positioner_set_constraint_adjustment(positioner, window->positioner.constraint_adjustment);
-    xdg_positioner_set_offset(positioner, window->positioner.offset.dx, window->positioner.offset.dy);
+    auto* const positioner{xdg_positioner_for(window->positioner, window->size)};
 
     return std::make_unique<PopupWindow>(
         window->surface,
@@ -186,26 +420,13 @@ auto mfa::Globals::make_tip_window(MirWindow* window) -> std::unique_ptr<XdgPopu
 
     if (!window->parent)
     {
-        std::cerr << "Tip window must have a parent.\n";
+        MFA_LOG(error, "globals", "Tip window must have a parent");
         std::abort();
     }
 
-    auto* const parent{std::holds_alternative<std::unique_ptr<mfa::XdgToplevelWindow>>(window->parent->window) ?
-        static_cast<xdg_surface*>(*std::get<std::unique_ptr<mfa::XdgToplevelWindow>>(window->parent->window)) :
-        static_cast<xdg_surface*>(*std::get<std::unique_ptr<mfa::XdgPopupWindow>>(window->parent->window))};
+    auto* const parent{parent_xdg_surface(window)};
 
-    auto* const positioner{xdg_wm_base_create_positioner(wm_base_)};
-    xdg_positioner_set_size(positioner, window->size.width, window->size.height);
-    xdg_positioner_set_anchor_rect(
-        positioner,
-        window->positioner.anchor_rect.x,
-        window->positioner.anchor_rect.y,
-        window->positioner.anchor_rect.width,
-        window->positioner.anchor_rect.height);
-    xdg_positioner_set_anchor(positioner, window->positioner.anchor);
-    xdg_positioner_set_gravity(positioner, window->positioner.gravity);
-    xdg_positioner_set_constraint_adjustment(positioner, window->positioner.constraint_adjustment);
-    xdg_positioner_set_offset(positioner, window->positioner.offset.dx, window->positioner.offset.dy);
+    auto* const positioner{xdg_positioner_for(window->positioner, window->size)};
 
     return std::make_unique<TipWindow>(
         window->surface,
@@ -215,6 +436,17 @@ auto mfa::Globals::make_tip_window(MirWindow* window) -> std::unique_ptr<XdgPopu
         parent);
 }
 
+void mfa::Globals::reuse_popup_window(MirWindow* window)
+{
+    register_window(window);
+
+    std::get<std::unique_ptr<XdgPopupWindow>>(window->window)->attach(
+        parent_xdg_surface(window),
+        xdg_positioner_for(window->positioner, window->size),
+        window->size.width,
+        window->size.height);
+}
+
 auto mfa::Globals::make_dialog_window(MirWindow* window) -> std::unique_ptr<XdgToplevelWindow>
 {
     register_window(window);
@@ -231,6 +463,9 @@ void mfa::Globals::close_window(wl_surface* surface)
     auto* const mir_window{window_for(surface)};
     mir_flutter_app::Globals::instance().deregister_window(mir_window);
 
+    // The surface goes away with the widget, so a frame still being drawn for it must not be committed
+    std::visit([](auto const& window) { if (window) window->discard_pending_frame(); }, mir_window->window);
+
     std::vector<wl_surface*> children;
     for (auto const [_, window] : windows)
     {
@@ -245,16 +480,71 @@ void mfa::Globals::close_window(wl_surface* surface)
         close_window(surface);
     }
 
+    if (WindowPool::instance().release(mir_window)) return;
     gtk_widget_destroy(GTK_WIDGET(mir_window));
 }
 
-void mfa::Globals::register_window(MirWindow* window) { windows[window->surface] = window; }
+void mfa::Globals::reposition_window(MirWindow* window)
+{
+    // Windows not created yet are placed with the new positioner when they are
+    if (!is_registered(window)) return;
 
-void mfa::Globals::deregister_window(MirWindow* window) { windows.erase(window->surface); }
+    if (window->archetype == MirWindowArchetype::satellite)
+    {
+        static_cast<SatelliteWindow*>(std::get<std::unique_ptr<XdgToplevelWindow>>(window->window).get())->
+            reposition();
+    }
+    else if (window->archetype == MirWindowArchetype::popup || window->archetype == MirWindowArchetype::tip)
+    {
+        std::get<std::unique_ptr<XdgPopupWindow>>(window->window)->reposition();
+    }
+}
+
+void mfa::Globals::trim_buffers(Window const* except)
+{
+    auto& budget{MemoryBudget::instance()};
+    size_t freed{0};
+
+    std::shared_lock lock{windows_mutex};
+    for (auto const [_, mir_window] : windows)
+    {
+        if (!budget.exceeded()) break;
+        if (mir_window == keyboard_focus) continue;
+
+        std::visit([&](auto const& window)
+            {
+                if (window && window.get() != except)
+                {
+                    freed += window->drop_back_buffers();
+                }
+            }, mir_window->window);
+    }
+
+    Stats::instance().add(Stats::Counter::back_buffer_bytes_dropped, freed);
+    MFA_LOG(debug, "memory", "Dropped ", freed, " bytes of back buffers, ", budget.used(), " bytes in use");
+}
+
+void mfa::Globals::register_window(MirWindow* window)
+{
+    std::unique_lock lock{windows_mutex};
+    windows[window->surface] = window;
+}
+
+void mfa::Globals::deregister_window(MirWindow* window)
+{
+    std::unique_lock lock{windows_mutex};
+    windows.erase(window->surface);
+
+    // Input is dispatched to the focused windows without looking them up, so they must never be closed ones
+    if (mouse_focus == window) mouse_focus = nullptr;
+    if (keyboard_focus == window) keyboard_focus = nullptr;
+}
 
 auto mfa::Globals::window_for(wl_surface* surface) -> MirWindow*
 {
-    return windows.contains(surface) ? windows[surface] : nullptr;
+    std::shared_lock lock{windows_mutex};
+    auto const window{windows.find(surface)};
+    return window != windows.end() ? window->second : nullptr;
 }
 
 bool mfa::Globals::is_registered(MirWindow* window) const { return window && windows.contains(window->surface); }
@@ -285,8 +575,18 @@ void mfa::Globals::handle_wl_registry_global(
         version = std::min(version, 1u);
         shm_ = static_cast<wl_shm*>(wl_registry_bind(registry, id, &wl_shm_interface, version));
         bound = true;
-        // Normally we'd add a listener to pick up the supported formats here
-        // As luck would have it, I know that argb8888 is the only format we support :)
+
+        // The formats are advertised right after binding, before handle_formats_received chooses a buffer backend
+        static wl_shm_listener const shm_listener{
+            .format = [](void* ctx, auto... args) { static_cast<Globals*>(ctx)->handle_shm_format(args...); }};
+        wl_shm_add_listener(shm_, &shm_listener, this);
+    }
+    else if (!subcompositor_ && name == wl_subcompositor_interface.name && wl_subcompositor_interface.version >= 1)
+    {
+        version = std::min(version, 1u);
+        subcompositor_ =
+            static_cast<wl_subcompositor*>(wl_registry_bind(registry, id, &wl_subcompositor_interface, version));
+        bound = true;
     }
     else if (!seat_ && name == wl_seat_interface.name && wl_seat_interface.version >= 1)
     {
@@ -301,84 +601,109 @@ void mfa::Globals::handle_wl_registry_global(
             static_cast<mir_shell_v1*>(wl_registry_bind(registry, id, &mir_shell_v1_interface, std::min(version, 1u)));
         bound = true;
     }
+    else if (!linux_dmabuf && name == zwp_linux_dmabuf_v1_interface.name && version >= 3)
+    {
+        // Version 3 is the last one to advertise format and modifier pairs without feedback objects
+        version = std::min(version, 3u);
+        linux_dmabuf =
+            static_cast<zwp_linux_dmabuf_v1*>(wl_registry_bind(registry, id, &zwp_linux_dmabuf_v1_interface, version));
+        bound = true;
+
+        static zwp_linux_dmabuf_v1_listener const dmabuf_listener{
+            .format = [](auto...) {},
+            .modifier = [](void* ctx, auto... args) { static_cast<Globals*>(ctx)->handle_dmabuf_modifier(args...); }};
+        zwp_linux_dmabuf_v1_add_listener(linux_dmabuf, &dmabuf_listener, this);
+    }
     else if (!wm_base_ && name == xdg_wm_base_interface.name && xdg_wm_base_interface.version >= 1)
     {
-        version = std::min(version, 1u);
-        wm_base_ =
-            static_cast<xdg_wm_base*>(wl_registry_bind(registry, id, &xdg_wm_base_interface, std::min(version, 1u)));
+        // Version 3 adds xdg_popup.reposition, version 6 the suspended toplevel state
+        version = std::min(version, 6u);
+        wm_base_ = static_cast<xdg_wm_base*>(wl_registry_bind(registry, id, &xdg_wm_base_interface, version));
         bound = true;
     }
 
     if (bound)
     {
-        std::cout << "Bound to " << name << " (v" << version << ")" << std::endl;
+        MFA_LOG(info, "globals", "Bound to ", name, " (v", version, ")");
+    }
+}
+
+void mfa::Globals::handle_shm_format(wl_shm* /*shm*/, uint32_t format)
+{
+    shm_formats.insert(format);
+}
+
+void mfa::Globals::handle_dmabuf_modifier(
+    zwp_linux_dmabuf_v1* /*linux_dmabuf*/,
+    uint32_t format,
+    uint32_t modifier_hi,
+    uint32_t modifier_lo)
+{
+    // Only linear buffers can be written directly by the CPU
+    if (modifier_hi == 0 && modifier_lo == 0)
+    {
+        dmabuf_linear_formats.insert(format);
     }
 }
 
 void mfa::Globals::handle_mouse_enter(
-    wl_pointer* /*pointer*/,
-    uint32_t /*serial*/,
+    wl_pointer* pointer,
+    uint32_t serial,
     wl_surface* surface,
     wl_fixed_t surface_x,
     wl_fixed_t surface_y)
 {
     mouse_focus = window_for(surface);
+    EventRecorder::instance().record(
+        EventRecorder::Kind::pointer_enter,
+        window_id(mouse_focus),
+        {static_cast<uint32_t>(surface_x), static_cast<uint32_t>(surface_y)});
 
-    // if (mouse_focus)
-    // {
-    //     std::cout << "Window " << mouse_focus->id;
-    // }
-    // else
-    // {
-    //     std::cout << "Main window";
-    // }
-    // std::cout << " - ";
+    MFA_LOG(trace, "input", window_name(mouse_focus), " - mouse_enter: (", wl_fixed_to_double(surface_x), ", ",
+        wl_fixed_to_double(surface_y), ")");
 
-    // std::cout << "mouse_enter: (" << std::fixed << std::setprecision(2)
-    //     << wl_fixed_to_double(surface_x) << ", " << wl_fixed_to_double(surface_y) << ")" << std::endl;
+    if (mouse_focus)
+    {
+        mouse_focus->base_window->handle_mouse_enter(
+            pointer,
+            serial,
+            wl_fixed_to_double(surface_x),
+            wl_fixed_to_double(surface_y));
+    }
 }
 
-void mfa::Globals::handle_mouse_leave(wl_pointer* /*pointer*/, uint32_t /*serial*/, wl_surface* surface)
+void mfa::Globals::handle_mouse_leave(wl_pointer* pointer, uint32_t serial, wl_surface* surface)
 {
-    // if (mouse_focus)
-    // {
-    //     std::cout << "Window " << mouse_focus->id;
-    // }
-    // else
-    // {
-    //     std::cout << "Main window";
-    // }
-    // std::cout << " - ";
+    MFA_LOG(trace, "input", window_name(mouse_focus), " - mouse_leave");
+    EventRecorder::instance().record(EventRecorder::Kind::pointer_leave, window_id(window_for(surface)));
 
-    // std::cout << "mouse_leave" << std::endl;
-
-    if (mouse_focus == window_for(surface))
+    if (mouse_focus && mouse_focus == window_for(surface))
     {
+        mouse_focus->base_window->handle_mouse_leave(pointer, serial);
         mouse_focus = nullptr;
     }
 }
 
 void mfa::Globals::handle_mouse_motion(
-    wl_pointer* /*pointer*/,
-    uint32_t/*time*/,
+    wl_pointer* pointer,
+    uint32_t time,
     wl_fixed_t surface_x,
     wl_fixed_t surface_y)
 {
-    // if (mouse_focus)
-    // {
-    //     std::cout << "Window " << mouse_focus->id;
-    // }
-    // else
-    // {
-    //     std::cout << "Main window";
-    // }
-    // std::cout << " - ";
-
-    // std::cout << "mouse_motion: (" << std::fixed << std::setprecision(2)
-    //     << wl_fixed_to_double(surface_x) << ", " << wl_fixed_to_double(surface_y)
-    //     << ") @ " << time << std::endl;
+    MFA_LOG(trace, "input", window_name(mouse_focus), " - mouse_motion: (", wl_fixed_to_double(surface_x), ", ",
+        wl_fixed_to_double(surface_y), ") @ ", time);
+    EventRecorder::instance().record(
+        EventRecorder::Kind::pointer_motion,
+        window_id(mouse_focus),
+        {time, static_cast<uint32_t>(surface_x), static_cast<uint32_t>(surface_y)});
 
     pointer_position_ = {wl_fixed_to_double(surface_x), wl_fixed_to_double(surface_y)};
+
+    if (mouse_focus)
+    {
+        auto const [x, y]{pointer_position_};
+        mouse_focus->base_window->handle_mouse_motion(pointer, time, x, y);
+    }
 }
 
 void mfa::Globals::handle_mouse_button(
@@ -388,31 +713,16 @@ void mfa::Globals::handle_mouse_button(
     uint32_t button,
     uint32_t state)
 {
-    // if (mouse_focus)
-    // {
-    //     std::cout << "Window " << mouse_focus->id;
-    // }
-    // else
-    // {
-    //     std::cout << "Main window";
-    // }
-    // std::cout << " - ";
-
-    // std::cout << "mouse_button: button " << button << ", state " << state
-    //     << " @ " << time << std::endl;
-
-    if (is_registered(mouse_focus))
+    MFA_LOG(trace, "input", window_name(mouse_focus), " - mouse_button: button ", button, ", state ", state, " @ ",
+        time);
+    EventRecorder::instance().record(
+        EventRecorder::Kind::pointer_button,
+        window_id(mouse_focus),
+        {serial, time, button, state});
+
+    if (mouse_focus)
     {
-        if (std::holds_alternative<std::unique_ptr<mfa::XdgToplevelWindow>>(mouse_focus->window))
-        {
-            std::get<std::unique_ptr<mfa::XdgToplevelWindow>>(mouse_focus->window)->
-                handle_mouse_button(pointer, serial, time, button, state);
-        }
-        else
-        {
-            std::get<std::unique_ptr<mfa::XdgPopupWindow>>(mouse_focus->window)->
-                handle_mouse_button(pointer, serial, time, button, state);
-        }
+        mouse_focus->base_window->handle_mouse_button(pointer, serial, time, button, state);
     }
 }
 
@@ -420,32 +730,14 @@ void mfa::Globals::handle_keyboard_enter(wl_keyboard* /*keyboard*/, uint32_t, wl
 {
     keyboard_focus = window_for(surface);
 
-    // if (keyboard_focus)
-    // {
-    //     std::cout << "Window " << keyboard_focus->id;
-    // }
-    // else
-    // {
-    //     std::cout << "Main window";
-    // }
-    // std::cout << " - ";
-
-    // std::cout << "keyboard_enter" << std::endl;
+    MFA_LOG(trace, "input", window_name(keyboard_focus), " - keyboard_enter");
+    EventRecorder::instance().record(EventRecorder::Kind::keyboard_enter, window_id(keyboard_focus));
 }
 
 void mfa::Globals::handle_keyboard_leave(wl_keyboard* /*keyboard*/, uint32_t, wl_surface* surface)
 {
-    // if (keyboard_focus)
-    // {
-    //     std::cout << "Window " << keyboard_focus->id;
-    // }
-    // else
-    // {
-    //     std::cout << "Main window";
-    // }
-    // std::cout << " - ";
-
-    // std::cout << "keyboard_leave" << std::endl;
+    MFA_LOG(trace, "input", window_name(keyboard_focus), " - keyboard_leave");
+    EventRecorder::instance().record(EventRecorder::Kind::keyboard_leave, window_id(window_for(surface)));
 
     if (keyboard_focus == window_for(surface))
     {
@@ -460,30 +752,15 @@ void mfa::Globals::handle_keyboard_key(
     uint32_t key,
     uint32_t state)
 {
-    // if (keyboard_focus)
-    // {
-    //     std::cout << "Window " << keyboard_focus->id;
-    // }
-    // else
-    // {
-    //     std::cout << "Main window";
-    // }
-    // std::cout << " - ";
+    MFA_LOG(trace, "input", window_name(keyboard_focus), " - keyboard_key: key ", key, ", state ", state);
+    EventRecorder::instance().record(
+        EventRecorder::Kind::keyboard_key,
+        window_id(keyboard_focus),
+        {serial, time, key, state});
 
-    // std::cout << "keyboard_key: key " << key << ", state " << state << std::endl;
-
-    if (is_registered(keyboard_focus))
+    if (keyboard_focus)
     {
-        if (std::holds_alternative<std::unique_ptr<mfa::XdgToplevelWindow>>(keyboard_focus->window))
-        {
-            std::get<std::unique_ptr<mfa::XdgToplevelWindow>>(keyboard_focus->window)->
-                handle_keyboard_key(keyboard, serial, time, key, state);
-        }
-        else
-        {
-            std::get<std::unique_ptr<mfa::XdgPopupWindow>>(keyboard_focus->window)->
-                handle_keyboard_key(keyboard, serial, time, key, state);
-        }
+        keyboard_focus->base_window->handle_keyboard_key(keyboard, serial, time, key, state);
     }
 }
 
@@ -495,45 +772,21 @@ void mfa::Globals::handle_keyboard_modifiers(
     uint32_t mods_locked,
     uint32_t group)
 {
-    // if (keyboard_focus)
-    // {
-    //     std::cout << "Window " << keyboard_focus->id;
-    // }
-    // else
-    // {
-    //     std::cout << "Main window";
-    // }
-    // std::cout << " - ";
-
-    // std::cout << "keyboard_modifiers: depressed " << mods_depressed
-    //     << ", latched " << mods_latched
-    //     << ", locked " << mods_locked
-    //     << ", group " << group
-    //     << std::endl;
-
-    if (is_registered(keyboard_focus))
-    {
-        if (std::holds_alternative<std::unique_ptr<mfa::XdgToplevelWindow>>(keyboard_focus->window))
-        {
-            std::get<std::unique_ptr<mfa::XdgToplevelWindow>>(keyboard_focus->window)->
-                handle_keyboard_modifiers(
-                keyboard,
-                serial,
-                mods_depressed,
-                mods_latched,
-                mods_locked,
-                group);
-        }
-        else
-        {
-            std::get<std::unique_ptr<mfa::XdgPopupWindow>>(keyboard_focus->window)->
-                handle_keyboard_modifiers(
-                keyboard,
-                serial,
-                mods_depressed,
-                mods_latched,
-                mods_locked,
-                group);
-        }
+    MFA_LOG(trace, "input", window_name(keyboard_focus), " - keyboard_modifiers: depressed ", mods_depressed,
+        ", latched ", mods_latched, ", locked ", mods_locked, ", group ", group);
+    EventRecorder::instance().record(
+        EventRecorder::Kind::keyboard_modifiers,
+        window_id(keyboard_focus),
+        {mods_depressed, mods_latched, mods_locked, group});
+
+    if (keyboard_focus)
+    {
+        keyboard_focus->base_window->handle_keyboard_modifiers(
+            keyboard,
+            serial,
+            mods_depressed,
+            mods_latched,
+            mods_locked,
+            group);
     }
 }
@@ -1,13 +1,22 @@
 #ifndef GLOBALS_H_
 #define GLOBALS_H_
 
+#include "buffer_backend.h"
+#include "positioner_cache.h"
+
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
+#include <set>
+#include <shared_mutex>
+#include <vector>
 
 struct wl_array;
 struct wl_compositor;
 struct wl_display;
+struct wl_event_queue;
 struct wl_keyboard;
 struct wl_output;
 struct wl_pointer;
@@ -16,17 +25,24 @@ struct wl_registry_listener;
 struct wl_seat;
 struct wl_surface;
 struct wl_shm;
+struct wl_subcompositor;
+struct xdg_positioner;
 struct xdg_wm_base;
 struct xdg_wm_base_listener;
+struct zwp_linux_dmabuf_v1;
 
 struct mir_positioner_v1;
 struct mir_shell_v1;
 
 using MirWindow = struct _MirWindow;
+struct MirWindowPositioner;
+struct MirWindowSize;
 using wl_fixed_t = int32_t;
 
 namespace mir_flutter_app
 {
+class EventReplayer;
+class Window;
 class XdgPopupWindow;
 class XdgToplevelWindow;
 
@@ -45,34 +61,67 @@ public:
         return instance;
     }
 
+    // Starts binding the globals without waiting for the compositor
     void bind_interfaces(wl_display* wl_display);
-    void init_cairo();
+    // Runs the callback once the globals are bound and a buffer backend is chosen, right away if they already are
+    void when_ready(std::function<void()> callback);
+    // Does the one-time work the first window would otherwise pay for: loading the fonts windows draw with, starting
+    // the render threads, and creating a first buffer and surface. Must be called once ready.
+    void prewarm();
 
     auto compositor() const -> wl_compositor* { return compositor_; }
     auto display() const -> wl_display* { return display_; }
+    auto event_queue() const -> wl_event_queue* { return event_queue_; }
     auto output() const -> wl_output* { return output_; }
     auto seat() const -> wl_seat* { return seat_; }
     auto shm() const -> wl_shm* { return shm_; }
+    auto subcompositor() const -> wl_subcompositor* { return subcompositor_; }
     auto wm_base() const -> xdg_wm_base* { return wm_base_; }
     auto mir_shell() const -> mir_shell_v1* { return mir_shell_; }
 
+    auto supports_shm_format(uint32_t format) const -> bool { return shm_formats.contains(format); }
+    auto buffer_backend() const -> BufferBackend& { return *buffer_backend_; }
+
     auto make_regular_window(MirWindow* window) -> std::unique_ptr<XdgToplevelWindow>;
     auto make_floating_regular_window(MirWindow* window) -> std::unique_ptr<XdgToplevelWindow>;
     auto make_dialog_window(MirWindow* window) -> std::unique_ptr<XdgToplevelWindow>;
     auto make_satellite_window(MirWindow* window) -> std::unique_ptr<XdgToplevelWindow>;
     auto make_popup_window(MirWindow* window) -> std::unique_ptr<XdgPopupWindow>;
     auto make_tip_window(MirWindow* window) -> std::unique_ptr<XdgPopupWindow>;
+    // Gives a popup or tip window taken from the WindowPool its new parent and placement
+    void reuse_popup_window(MirWindow* window);
     void close_window(wl_surface* surface);
+    // Moves a window to where its current positioner places it
+    void reposition_window(MirWindow* window);
+
+    // Configured positioners for the placement, shared by the windows placed alike. They stay owned by Globals.
+    auto mir_positioner_for(MirWindowPositioner const& positioner) -> mir_positioner_v1*;
+    auto xdg_positioner_for(MirWindowPositioner const& positioner, MirWindowSize const& size) -> xdg_positioner*;
 
     auto window_for(wl_surface* surface) -> MirWindow*;
+    // Drops the back buffers of the windows without keyboard focus, other than except, until the MemoryBudget is
+    // no longer exceeded
+    void trim_buffers(Window const* except);
     auto pointer_position() -> std::tuple<double, double> { return pointer_position_; }
 
 private:
+    // Feeds recorded input back into the handlers below
+    friend class EventReplayer;
+
     void register_window(MirWindow* window);
     void deregister_window(MirWindow* window);
     auto is_registered(MirWindow* window) const -> bool;
 
+    void handle_globals_bound();
+    void handle_formats_received();
+    void handle_buffer_backend_chosen(std::unique_ptr<BufferBackend> backend);
     void handle_wl_registry_global(wl_registry* registry, uint32_t id, char const* interface, uint32_t version);
+    void handle_shm_format(wl_shm* shm, uint32_t format);
+    void handle_dmabuf_modifier(
+        zwp_linux_dmabuf_v1* linux_dmabuf,
+        uint32_t format,
+        uint32_t modifier_hi,
+        uint32_t modifier_lo);
 
     void handle_mouse_button(wl_pointer*, uint32_t serial, uint32_t time, uint32_t button, uint32_t state);
     void handle_keyboard_key(wl_keyboard* keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state);
@@ -97,21 +146,39 @@ private:
 
     wl_compositor* compositor_{};
     wl_display* display_{};
+    wl_event_queue* event_queue_{};
+    wl_display* display_wrapper{};
     wl_output* output_{};
     wl_seat* seat_{};
     wl_shm* shm_{};
+    wl_subcompositor* subcompositor_{};
     xdg_wm_base* wm_base_{};
     mir_shell_v1* mir_shell_{};
+    zwp_linux_dmabuf_v1* linux_dmabuf{};
+
+    std::unique_ptr<BufferBackend> buffer_backend_;
+
+    PositionerCache<mir_positioner_v1> mir_positioners;
+    PositionerCache<xdg_positioner> xdg_positioners;
 
     wl_pointer* pointer{};
     wl_keyboard* keyboard{};
     MirWindow* mouse_focus{};
     MirWindow* keyboard_focus{};
 
+    std::set<uint32_t> shm_formats;
+    std::set<uint32_t> dmabuf_linear_formats;
     std::map<wl_surface*, MirWindow*> windows;
+    // Only changed on the main thread, but also looked up while drawing on the render thread
+    std::shared_mutex windows_mutex;
 
     std::tuple<double, double> pointer_position_;
 
+    bool ready{};
+    std::vector<std::function<void()>> waiting_for_ready;
+    std::chrono::steady_clock::time_point bind_started;
+    std::chrono::steady_clock::time_point globals_bound;
+
     Globals() = default;
 };
 }
@@ -0,0 +1,56 @@
+#include "hit_regions.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace
+{
+auto cell_index(std::vector<double> const& edges, double value) -> size_t
+{
+    return std::upper_bound(edges.begin(), edges.end(), value) - edges.begin() - 1;
+}
+}
+
+namespace mfa = mir_flutter_app;
+
+mfa::HitRegions::HitRegions(std::vector<Area> const& areas)
+{
+    for (auto const& area : areas)
+    {
+        columns.insert(columns.end(), {area.left, area.right});
+        rows.insert(rows.end(), {area.top, area.bottom});
+    }
+    std::ranges::sort(columns);
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+    std::ranges::sort(rows);
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    if (columns.size() < 2 || rows.size() < 2) return;
+
+    auto const row_length{columns.size() - 1};
+    cells.assign(row_length * (rows.size() - 1), HitRegion::none);
+    for (auto const& area : areas)
+    {
+        // Every area edge is a grid line, so an area covers whole cells
+        auto const first_column{cell_index(columns, area.left)};
+        auto const last_column{cell_index(columns, area.right)};
+        auto const first_row{cell_index(rows, area.top)};
+        auto const last_row{cell_index(rows, area.bottom)};
+        for (auto row{first_row}; row < last_row; ++row)
+        {
+            std::fill(
+                cells.begin() + row * row_length + first_column,
+                cells.begin() + row * row_length + last_column,
+                area.region);
+        }
+    }
+}
+
+auto mfa::HitRegions::at(double x, double y) const -> HitRegion
+{
+    if (cells.empty() || x < columns.front() || x >= columns.back() || y < rows.front() || y >= rows.back())
+    {
+        return HitRegion::none;
+    }
+
+    return cells[cell_index(rows, y) * (columns.size() - 1) + cell_index(columns, x)];
+}
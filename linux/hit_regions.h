@@ -0,0 +1,56 @@
+#ifndef HIT_REGIONS_H_
+#define HIT_REGIONS_H_
+
+#include <vector>
+
+namespace mir_flutter_app
+{
+// Parts of a window that respond differently to the pointer
+enum class HitRegion
+{
+    none,
+    client,
+    title_bar,
+    close_button,
+    minimize_button,
+    maximize_button,
+    resize_top,
+    resize_bottom,
+    resize_left,
+    resize_right,
+    resize_top_left,
+    resize_top_right,
+    resize_bottom_left,
+    resize_bottom_right
+};
+
+// Maps points of a window to the region under them. The areas are laid out once per layout change into a grid
+// split at every area edge, so finding the region under a point is a binary search on each axis and a table lookup.
+class HitRegions
+{
+public:
+    struct Area
+    {
+        HitRegion region;
+        double left;
+        double top;
+        double right;
+        double bottom;
+    };
+
+    HitRegions() = default;
+    // Where areas overlap, the ones that come later take precedence. Areas include their left and top edges but
+    // not their right and bottom ones.
+    explicit HitRegions(std::vector<Area> const& areas);
+
+    auto at(double x, double y) const -> HitRegion;
+
+private:
+    std::vector<double> columns;
+    std::vector<double> rows;
+    // Region of the cell between each pair of consecutive columns and rows, row by row
+    std::vector<HitRegion> cells;
+};
+}
+
+#endif // HIT_REGIONS_H_
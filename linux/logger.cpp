@@ -0,0 +1,164 @@
+#include "logger.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+
+namespace
+{
+auto now_us() -> int64_t
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+auto level_name(mir_flutter_app::LogLevel level) -> std::string_view
+{
+    switch (level)
+    {
+        case mir_flutter_app::LogLevel::trace:   return "trace";
+        case mir_flutter_app::LogLevel::debug:   return "debug";
+        case mir_flutter_app::LogLevel::info:    return "info";
+        case mir_flutter_app::LogLevel::warning: return "warning";
+        case mir_flutter_app::LogLevel::error:   return "error";
+    }
+    return {};
+}
+}
+
+namespace mfa = mir_flutter_app;
+
+mfa::Logger::Logger() :
+    start_us{now_us()}
+{
+    for (size_t i{0}; i < capacity; ++i)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    writer = std::thread{[this] { run_writer(); }};
+}
+
+mfa::Logger::~Logger()
+{
+    stopping = true;
+    writer_idle = false;
+    writer_idle.notify_one();
+    writer.join();
+}
+
+void mfa::Logger::submit(Record& record)
+{
+    record.timestamp_us = now_us();
+    record.thread = static_cast<uint32_t>(gettid());
+
+    if (record.level == LogLevel::error)
+    {
+        write(record);
+        return;
+    }
+
+    // Bounded multi-producer queue: a slot is free for position p when its sequence is p, and holds a record
+    // for the writer when its sequence is p + 1
+    auto position{enqueue_position.load(std::memory_order_relaxed)};
+    while (true)
+    {
+        auto& slot{slots[position % capacity]};
+        auto const sequence{slot.sequence.load(std::memory_order_acquire)};
+
+        if (sequence == position)
+        {
+            if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                slot.record = record;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                wake_writer();
+                return;
+            }
+        }
+        else if (sequence < position)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void mfa::Logger::wake_writer()
+{
+    // Pairs with the fence in run_writer, so either the writer sees the record or the record's producer sees the
+    // writer idle
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writer_idle.load(std::memory_order_relaxed) && writer_idle.exchange(false))
+    {
+        writer_idle.notify_one();
+    }
+}
+
+void mfa::Logger::write(Record const& record) const
+{
+    std::array<char, 32> timestamp;
+    auto const elapsed_us{record.timestamp_us - start_us};
+    auto const [end, _]{std::to_chars(timestamp.data(), timestamp.data() + timestamp.size(), elapsed_us / 1e6,
+        std::chars_format::fixed, 6)};
+
+    std::string line;
+    line.reserve(record.length + 64);
+    line.append(timestamp.data(), end).append(" ").append(level_name(record.level)).append(" [")
+        .append(std::to_string(record.thread)).append("] ").append(record.component).append(": ")
+        .append(record.text.data(), record.length).append("\n");
+
+    auto const fd{record.level >= LogLevel::warning ? STDERR_FILENO : STDOUT_FILENO};
+    [[maybe_unused]] auto const written{::write(fd, line.data(), line.size())};
+}
+
+auto mfa::Logger::write_queued() -> bool
+{
+    auto wrote{false};
+    while (true)
+    {
+        auto& slot{slots[dequeue_position % capacity]};
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_position + 1) break;
+
+        write(slot.record);
+        slot.sequence.store(dequeue_position + capacity, std::memory_order_release);
+        ++dequeue_position;
+        wrote = true;
+    }
+
+    if (auto const count{dropped.exchange(0, std::memory_order_relaxed)})
+    {
+        Record record{.level = LogLevel::warning, .component = "logger", .timestamp_us = now_us()};
+        append(record, "Dropped ");
+        append(record, count);
+        append(record, " messages");
+        write(record);
+    }
+
+    return wrote;
+}
+
+void mfa::Logger::run_writer()
+{
+    while (!stopping)
+    {
+        if (write_queued()) continue;
+
+        writer_idle = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // A record may have been queued before its producer could see the writer idle
+        if (write_queued() || stopping)
+        {
+            writer_idle = false;
+            continue;
+        }
+        writer_idle.wait(true);
+    }
+
+    write_queued();
+}
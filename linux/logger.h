@@ -0,0 +1,135 @@
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+// Messages below this level are compiled out: 0 trace, 1 debug, 2 info, 3 warning, 4 error
+#ifndef MIR_FLUTTER_APP_LOG_LEVEL
+#define MIR_FLUTTER_APP_LOG_LEVEL 2
+#endif
+
+// Logs the remaining arguments, concatenated, under the given level and component. Arguments are not evaluated
+// when the level is compiled out.
+#define MFA_LOG(level, component, ...)                                                                   \
+    do                                                                                                   \
+    {                                                                                                    \
+        if constexpr (static_cast<int>(::mir_flutter_app::LogLevel::level) >= MIR_FLUTTER_APP_LOG_LEVEL) \
+        {                                                                                                \
+            ::mir_flutter_app::Logger::instance().log(                                                   \
+                ::mir_flutter_app::LogLevel::level, component, __VA_ARGS__);                             \
+        }                                                                                                \
+    } while (false)
+
+namespace mir_flutter_app
+{
+enum class LogLevel
+{
+    trace,
+    debug,
+    info,
+    warning,
+    error,
+};
+
+// Formats messages into fixed-size records on the calling thread, without allocating, and queues them on a
+// lock-free ring buffer that a background thread writes out. Errors are written straight away, as they usually
+// precede an abort. Messages are dropped rather than block when the buffer is full.
+class Logger
+{
+public:
+    Logger(Logger const&) = delete;
+    Logger(Logger&&) = delete;
+    Logger& operator=(Logger const&) = delete;
+    Logger& operator=(Logger&&) = delete;
+    ~Logger();
+
+    static Logger& instance()
+    {
+        static Logger instance;
+        return instance;
+    }
+
+    // The component must be a string literal, as only the pointer is queued
+    template<typename... Args>
+    void log(LogLevel level, char const* component, Args const&... args)
+    {
+        Record record{.level = level, .component = component};
+        (append(record, args), ...);
+        submit(record);
+    }
+
+private:
+    struct Record
+    {
+        LogLevel level;
+        char const* component;
+        int64_t timestamp_us;
+        uint32_t thread;
+        uint16_t length;
+        std::array<char, 200> text;
+    };
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        Record record;
+    };
+
+    static size_t const capacity{1024};
+
+    std::array<Slot, capacity> slots;
+    std::atomic<uint64_t> enqueue_position{};
+    uint64_t dequeue_position{};
+    std::atomic<uint64_t> dropped{};
+    int64_t start_us;
+
+    std::atomic<bool> stopping{};
+    // Set while the writer waits for records. Only producers that find it set make a system call to wake it.
+    std::atomic<bool> writer_idle{};
+    std::thread writer;
+
+    static void append(Record& record, std::string_view text)
+    {
+        auto const length{std::min(text.size(), record.text.size() - record.length)};
+        std::memcpy(record.text.data() + record.length, text.data(), length);
+        record.length += length;
+    }
+
+    static void append(Record& record, char const* text) { append(record, std::string_view{text}); }
+
+    static void append(Record& record, char c) { append(record, std::string_view{&c, 1}); }
+
+    static void append(Record& record, std::integral auto value)
+    {
+        auto const end{record.text.data() + record.text.size()};
+        auto const [pointer, error]{std::to_chars(record.text.data() + record.length, end, value)};
+        if (error == std::errc{}) record.length = pointer - record.text.data();
+    }
+
+    static void append(Record& record, std::floating_point auto value)
+    {
+        auto const end{record.text.data() + record.text.size()};
+        auto const [pointer, error]{
+            std::to_chars(record.text.data() + record.length, end, value, std::chars_format::fixed, 2)};
+        if (error == std::errc{}) record.length = pointer - record.text.data();
+    }
+
+    void submit(Record& record);
+    void wake_writer();
+    void write(Record const& record) const;
+    auto write_queued() -> bool;
+    void run_writer();
+
+    Logger();
+};
+}
+
+#endif // LOGGER_H_
@@ -1,7 +1,10 @@
 #include "my_application.h"
+#include "tracer.h"
 
 int main(int argc, char** argv)
 {
+    mir_flutter_app::Tracer::instance().instant("process start");
+
     g_autoptr(MyApplication) app = my_application_new();
     return g_application_run(G_APPLICATION(app), argc, argv);
 }
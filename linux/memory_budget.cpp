@@ -0,0 +1,27 @@
+#include "memory_budget.h"
+#include "logger.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+namespace mfa = mir_flutter_app;
+
+mfa::MemoryBudget::MemoryBudget()
+{
+    if (auto const* const value{std::getenv("MIR_FLUTTER_APP_MEMORY_BUDGET_MB")})
+    {
+        std::string_view const budget{value};
+        size_t megabytes{};
+        if (auto const [end, error]{std::from_chars(budget.data(), budget.data() + budget.size(), megabytes)};
+            error != std::errc{} || end != budget.data() + budget.size() || megabytes > (SIZE_MAX >> 20))
+        {
+            MFA_LOG(warning, "memory", "Invalid MIR_FLUTTER_APP_MEMORY_BUDGET_MB '", value, "', using no budget");
+            return;
+        }
+
+        budget_ = megabytes << 20;
+        MFA_LOG(info, "memory", "Buffer memory budget: ", budget_ >> 20, " MiB");
+    }
+}
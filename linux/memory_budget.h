@@ -0,0 +1,42 @@
+#ifndef MEMORY_BUDGET_H_
+#define MEMORY_BUDGET_H_
+
+#include <atomic>
+#include <cstddef>
+
+namespace mir_flutter_app
+{
+// Accounts for the buffer memory of every window against a process-wide budget, set in MiB through
+// MIR_FLUTTER_APP_MEMORY_BUDGET_MB. Without it, the memory is still accounted for but never limited.
+class MemoryBudget
+{
+public:
+    MemoryBudget(MemoryBudget const&) = delete;
+    MemoryBudget(MemoryBudget&&) = delete;
+    MemoryBudget& operator=(MemoryBudget const&) = delete;
+    MemoryBudget& operator=(MemoryBudget&&) = delete;
+    ~MemoryBudget() = default;
+
+    static MemoryBudget& instance()
+    {
+        static MemoryBudget instance;
+        return instance;
+    }
+
+    // 0 if there is no budget
+    auto budget() const -> size_t { return budget_; }
+    auto used() const -> size_t { return used_.load(std::memory_order_relaxed); }
+    auto exceeded() const -> bool { return budget_ && used() > budget_; }
+
+    void add(size_t bytes) { used_.fetch_add(bytes, std::memory_order_relaxed); }
+    void remove(size_t bytes) { used_.fetch_sub(bytes, std::memory_order_relaxed); }
+
+private:
+    size_t budget_{};
+    std::atomic<size_t> used_{};
+
+    MemoryBudget();
+};
+}
+
+#endif // MEMORY_BUDGET_H_
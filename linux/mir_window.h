@@ -5,12 +5,14 @@
 
 #include "mir-shell.h"
 
+#include <chrono>
 #include <memory>
 #include <set>
 #include <variant>
 
 namespace mir_flutter_app
 {
+class Window;
 class XdgToplevelWindow;
 class XdgPopupWindow;
 }
@@ -61,12 +63,16 @@ struct _MirWindow
     GtkWindow parent_instance;
 
     int id;
+    // When the Flutter app asked for the window
+    std::chrono::steady_clock::time_point created;
 
     MirWindow* parent;
     std::set<MirWindow*> children;
     MirWindowArchetype archetype;
 
     wl_surface* surface;
+    // Created directly from the compositor rather than by GTK
+    bool owns_surface;
     MirWindowSize size;
     MirWindowPositioner positioner;
 
@@ -75,6 +81,8 @@ struct _MirWindow
             std::unique_ptr<mir_flutter_app::XdgToplevelWindow>,
             std::unique_ptr<mir_flutter_app::XdgPopupWindow>
         > window;
+    // The object held by window as their common base, so input is dispatched without checking the alternative
+    mir_flutter_app::Window* base_window;
 };
 
 #endif // MIR_WINDOW_H_
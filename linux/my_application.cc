@@ -3,15 +3,27 @@
 
 #include <flutter_linux/flutter_linux.h>
 #include <gdk/gdkwayland.h>
+#include <glib-unix.h>
 
 #include "flutter/generated_plugin_registrant.h"
 
 #include "mir-shell.h"
+#include "event_replayer.h"
+#include "logger.h"
+#include "memory_budget.h"
 #include "mir_window.h"
+#include "stats.h"
+#include "tracer.h"
+#include "window_pool.h"
 #include "xdg_toplevel_window.h"
 #include "xdg_popup_window.h"
 
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <optional>
 
 namespace
 {
@@ -53,6 +65,43 @@ To arg(FlValue* args, size_t index)
     }
 }
 
+// Reads a positioner from the nine arguments starting at index: the anchor rectangle, the parent and child
+// anchors, the offset, and the constraint adjustment
+static auto positioner_arg(FlValue* args, size_t index) -> MirWindowPositioner
+{
+    // Convert from anchor (originally a FlutterViewPositionerAnchor) to mir_positioner_v1_gravity
+    auto const gravity{
+        [](mir_positioner_v1_anchor anchor) -> mir_positioner_v1_gravity
+        {
+            switch (anchor)
+            {
+            case MIR_POSITIONER_V1_ANCHOR_NONE: return MIR_POSITIONER_V1_GRAVITY_NONE;
+            case MIR_POSITIONER_V1_ANCHOR_TOP: return MIR_POSITIONER_V1_GRAVITY_BOTTOM;
+            case MIR_POSITIONER_V1_ANCHOR_BOTTOM: return MIR_POSITIONER_V1_GRAVITY_TOP;
+            case MIR_POSITIONER_V1_ANCHOR_LEFT: return MIR_POSITIONER_V1_GRAVITY_RIGHT;
+            case MIR_POSITIONER_V1_ANCHOR_RIGHT: return MIR_POSITIONER_V1_GRAVITY_LEFT;
+            case MIR_POSITIONER_V1_ANCHOR_TOP_LEFT: return MIR_POSITIONER_V1_GRAVITY_BOTTOM_RIGHT;
+            case MIR_POSITIONER_V1_ANCHOR_BOTTOM_LEFT: return MIR_POSITIONER_V1_GRAVITY_TOP_RIGHT;
+            case MIR_POSITIONER_V1_ANCHOR_TOP_RIGHT: return MIR_POSITIONER_V1_GRAVITY_BOTTOM_LEFT;
+            case MIR_POSITIONER_V1_ANCHOR_BOTTOM_RIGHT: return MIR_POSITIONER_V1_GRAVITY_TOP_LEFT;
+            }
+        }(arg<FL_VALUE_TYPE_INT, mir_positioner_v1_anchor>(args, index + 5))};
+
+    return {
+        .anchor_rect = {
+            .x = arg<FL_VALUE_TYPE_FLOAT, int>(args, index),
+            .y = arg<FL_VALUE_TYPE_FLOAT, int>(args, index + 1),
+            .width = arg<FL_VALUE_TYPE_FLOAT, int>(args, index + 2),
+            .height = arg<FL_VALUE_TYPE_FLOAT, int>(args, index + 3)},
+        .anchor = arg<FL_VALUE_TYPE_INT, mir_positioner_v1_anchor>(args, index + 4),
+        .gravity = gravity,
+        .offset = {
+            .dx = arg<FL_VALUE_TYPE_FLOAT, int>(args, index + 6),
+            .dy = arg<FL_VALUE_TYPE_FLOAT, int>(args, index + 7)},
+        .constraint_adjustment = arg<FL_VALUE_TYPE_INT, uint32_t>(args, index + 8)
+    };
+}
+
 static void mir_window_show(GtkWidget* widget)
 {
     gtk_window_set_decorated(GTK_WINDOW(widget), FALSE);
@@ -67,14 +116,13 @@ static void mir_window_realize(GtkWidget* widget)
     g_return_if_fail(GDK_IS_WAYLAND_WINDOW(gdk_window) == true);
 }
 
-static void mir_window_map(GtkWidget* widget)
+static void mir_window_create(MirWindow* self)
 {
-    MirWindow* const self{MIR_WINDOW(widget)};
-
-    gtk_widget_set_size_request(widget, self->size.width, self->size.height);
+    mfa::Tracer::instance().instant("create", self->id);
 
-    GdkWindow* const gdk_window{gtk_widget_get_window(widget)};
-    self->surface = gdk_wayland_window_get_wl_surface(gdk_window);
+    self->surface = self->owns_surface ?
+        wl_compositor_create_surface(mfa::Globals::instance().compositor()) :
+        gdk_wayland_window_get_wl_surface(gtk_widget_get_window(GTK_WIDGET(self)));
     if (self->archetype == MirWindowArchetype::regular)
     {
         self->window = mfa::Globals::instance().make_regular_window(self);
@@ -99,6 +147,50 @@ static void mir_window_map(GtkWidget* widget)
     {
         self->window = mfa::Globals::instance().make_tip_window(self);
     }
+    self->base_window = std::visit([](auto const& window) -> mfa::Window* { return window.get(); }, self->window);
+}
+
+static void mir_window_map(GtkWidget* widget)
+{
+    MirWindow* const self{MIR_WINDOW(widget)};
+
+    gtk_widget_set_size_request(widget, self->size.width, self->size.height);
+
+    // Windows requested before the Wayland globals are bound are created as soon as they are
+    g_object_ref(self);
+    mfa::Globals::instance().when_ready([self]
+        {
+            if (gtk_widget_get_mapped(GTK_WIDGET(self)))
+            {
+                mir_window_create(self);
+            }
+            g_object_unref(self);
+        });
+}
+
+// Creates the window's surface. Unless MIR_FLUTTER_APP_DIRECT_SURFACES is set, the GtkWindow is shown and its
+// surface is used. Otherwise, the surface is created from the compositor directly, and the GtkWindow is never
+// realized, which skips GTK's widget, GdkWindow, and surface setup entirely.
+static void mir_window_present(MirWindow* self)
+{
+    static bool const direct_surfaces{std::getenv("MIR_FLUTTER_APP_DIRECT_SURFACES") != nullptr};
+    if (!direct_surfaces)
+    {
+        gtk_widget_show(GTK_WIDGET(self));
+        return;
+    }
+
+    self->owns_surface = true;
+    g_object_ref(self);
+    mfa::Globals::instance().when_ready([self]
+        {
+            // Destroying the window before the Wayland globals are bound releases it from the application
+            if (gtk_window_get_application(GTK_WINDOW(self)))
+            {
+                mir_window_create(self);
+            }
+            g_object_unref(self);
+        });
 }
 
 static void method_response_cb(GObject* object, GAsyncResult* result, gpointer /*user_data*/)
@@ -120,13 +212,13 @@ static void method_response_cb(GObject* object, GAsyncResult* result, gpointer /
     }
 }
 
-static void mir_window_destroy(GtkWidget* widget)
+// Detaches a window from its parent and the application, and tells the Flutter app that it is closed
+static void mir_window_closed(MirWindow* self)
 {
-    MirWindow* const self{MIR_WINDOW(widget)};
-
     if (self->parent)
     {
         self->parent->children.erase(self);
+        self->parent = nullptr;
     }
 
     if (MyApplication* const application{MY_APPLICATION(gtk_window_get_application(GTK_WINDOW(self)))})
@@ -146,10 +238,25 @@ static void mir_window_destroy(GtkWidget* widget)
         }
         else
         {
-            std::cerr << "Could not find window id in the window map.\n";
+            MFA_LOG(error, "app", "Could not find window id in the window map");
             std::abort();
         }
     }
+}
+
+static void mir_window_destroy(GtkWidget* widget)
+{
+    MirWindow* const self{MIR_WINDOW(widget)};
+    mir_window_closed(self);
+
+    // GTK only destroys the surfaces it created
+    if (self->owns_surface && self->surface)
+    {
+        std::visit([](auto& window) { window.reset(); }, self->window);
+        self->base_window = nullptr;
+        wl_surface_destroy(self->surface);
+        self->surface = nullptr;
+    }
 
     GTK_WIDGET_CLASS(mir_window_parent_class)->destroy(widget);
 }
@@ -164,32 +271,98 @@ static void mir_window_class_init(MirWindowClass* klass)
 
 static void mir_window_init(MirWindow* self) {}
 
-static MirWindow* mir_window_new(
-    MirWindowArchetype archetype,
+// Sets up a window that is new or taken from the WindowPool
+static void mir_window_reset(
+    MirWindow* self,
     MirWindowSize size,
     MirWindowPositioner positioner,
-    MirWindow* parent, int id)
+    MirWindow* parent,
+    int id)
 {
-    MirWindow* const self{MIR_WINDOW(g_object_new(mir_window_get_type(), nullptr))};
-    self->archetype = archetype;
     self->size = size;
     self->positioner = positioner;
     self->parent = parent;
     self->children = {};
     self->id = id;
+    self->created = std::chrono::steady_clock::now();
+    mfa::Tracer::instance().begin_async("window", id);
 
     if (self->parent)
     {
         self->parent->children.insert(self);
     }
+}
+
+static MirWindow* mir_window_new(
+    MirWindowArchetype archetype,
+    MirWindowSize size,
+    MirWindowPositioner positioner,
+    MirWindow* parent, int id)
+{
+    MirWindow* const self{MIR_WINDOW(g_object_new(mir_window_get_type(), nullptr))};
+    self->archetype = archetype;
+    mir_window_reset(self, size, positioner, parent, id);
 
     return self;
 }
 
+// Appends the call to the file MIR_FLUTTER_APP_RECORD_CALLS names, if set, as a line with the time in microseconds
+// since the first call, the method name, and its arguments encoded by the standard message codec in base64
+static void record_method_call(FlMethodCall* method_call)
+{
+    static std::ofstream file{[]
+        {
+            auto const* const path{std::getenv("MIR_FLUTTER_APP_RECORD_CALLS")};
+            return path ? std::ofstream{path, std::ios::trunc} : std::ofstream{};
+        }()};
+    if (!file.is_open()) return;
+
+    static auto const start{std::chrono::steady_clock::now()};
+    static FlStandardMessageCodec* const codec{fl_standard_message_codec_new()};
+
+    g_autoptr(GError) error{nullptr};
+    g_autoptr(GBytes) args{
+        fl_message_codec_encode_message(FL_MESSAGE_CODEC(codec), fl_method_call_get_args(method_call), &error)};
+    if (!args) return;
+
+    gsize size{};
+    auto const* const data{static_cast<guchar const*>(g_bytes_get_data(args, &size))};
+    g_autofree gchar* const encoded{g_base64_encode(data, size)};
+    file << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()
+         << ' ' << fl_method_call_get_name(method_call) << ' ' << encoded << '\n';
+}
+
 static void mir_window_method_cb(FlMethodChannel* /*channel*/, FlMethodCall* method_call, gpointer user_data)
 {
     MyApplication* const self{MY_APPLICATION(user_data)};
 
+    std::string_view const name{fl_method_call_get_name(method_call)};
+    record_method_call(method_call);
+
+    mfa::Stats::instance().increment(mfa::Stats::Counter::method_calls);
+    mfa::Stats::Timer const timer{mfa::Stats::Histogram::method_call_time};
+    std::optional<mfa::Stats::Timer> method_timer;
+    if (name.starts_with("create"))
+    {
+        method_timer.emplace(mfa::Stats::Histogram::create_window_time);
+    }
+    else if (name == "closeWindow")
+    {
+        method_timer.emplace(mfa::Stats::Histogram::close_window_time);
+    }
+    else if (name.starts_with("getWindow"))
+    {
+        method_timer.emplace(mfa::Stats::Histogram::query_window_time);
+    }
+
+    // The first call comes once the engine runs the Dart entrypoint
+    static bool engine_ready{};
+    if (!engine_ready)
+    {
+        mfa::Tracer::instance().instant("engine ready");
+        engine_ready = true;
+    }
+
     auto const get_new_window_id{[](const std::map<int, MirWindow*>& windows)
         {
             auto new_id{0};
@@ -207,7 +380,6 @@ static void mir_window_method_cb(FlMethodChannel* /*channel*/, FlMethodCall* met
             return new_id;
         }};
 
-    std::string_view const name{fl_method_call_get_name(method_call)};
     if (name == "createRegularWindow")
     {
         FlValue* const args{fl_method_call_get_args(method_call)};
@@ -227,7 +399,7 @@ static void mir_window_method_cb(FlMethodChannel* /*channel*/, FlMethodCall* met
         MirWindow* const mir_window{mir_window_new(MirWindowArchetype::regular, size, {}, nullptr, new_id)};
         self->windows[mir_window->id] = mir_window;
         gtk_window_set_application(GTK_WINDOW(mir_window), GTK_APPLICATION(self));
-        gtk_widget_show(GTK_WIDGET(mir_window));
+        mir_window_present(mir_window);
 
         g_autoptr(FlValue) result{fl_value_new_int(mir_window->id)};
         fl_method_call_respond_success(method_call, result, nullptr);
@@ -250,7 +422,7 @@ static void mir_window_method_cb(FlMethodChannel* /*channel*/, FlMethodCall* met
         MirWindow* const mir_window{mir_window_new(MirWindowArchetype::floating_regular, size, {}, nullptr, new_id)};
         self->windows[mir_window->id] = mir_window;
         gtk_window_set_application(GTK_WINDOW(mir_window), GTK_APPLICATION(self));
-        gtk_widget_show(GTK_WIDGET(mir_window));
+        mir_window_present(mir_window);
 
         g_autoptr(FlValue) result{fl_value_new_int(mir_window->id)};
         fl_method_call_respond_success(method_call, result, nullptr);
@@ -282,37 +454,7 @@ static void mir_window_method_cb(FlMethodChannel* /*channel*/, FlMethodCall* met
             .width = arg<FL_VALUE_TYPE_FLOAT, int>(args, 1),
             .height = arg<FL_VALUE_TYPE_FLOAT, int>(args, 2)};
 
-        // Convert from anchor (originally a FlutterViewPositionerAnchor) to mir_positioner_v1_gravity
-        auto const gravity{
-            [](mir_positioner_v1_anchor anchor) -> mir_positioner_v1_gravity
-            {
-                switch (anchor)
-                {
-	            case MIR_POSITIONER_V1_ANCHOR_NONE: return MIR_POSITIONER_V1_GRAVITY_NONE;
-                case MIR_POSITIONER_V1_ANCHOR_TOP: return MIR_POSITIONER_V1_GRAVITY_BOTTOM;
-                case MIR_POSITIONER_V1_ANCHOR_BOTTOM: return MIR_POSITIONER_V1_GRAVITY_TOP;
-                case MIR_POSITIONER_V1_ANCHOR_LEFT: return MIR_POSITIONER_V1_GRAVITY_RIGHT;
-                case MIR_POSITIONER_V1_ANCHOR_RIGHT: return MIR_POSITIONER_V1_GRAVITY_LEFT;
-                case MIR_POSITIONER_V1_ANCHOR_TOP_LEFT: return MIR_POSITIONER_V1_GRAVITY_BOTTOM_RIGHT;
-                case MIR_POSITIONER_V1_ANCHOR_BOTTOM_LEFT: return MIR_POSITIONER_V1_GRAVITY_TOP_RIGHT;
-                case MIR_POSITIONER_V1_ANCHOR_TOP_RIGHT: return MIR_POSITIONER_V1_GRAVITY_BOTTOM_LEFT;
-                case MIR_POSITIONER_V1_ANCHOR_BOTTOM_RIGHT: return MIR_POSITIONER_V1_GRAVITY_TOP_LEFT;
-                }
-            }(arg<FL_VALUE_TYPE_INT, mir_positioner_v1_anchor>(args, 8))};
-
-        MirWindowPositioner const positioner{
-            .anchor_rect = {
-                .x = arg<FL_VALUE_TYPE_FLOAT, int>(args, 3),
-                .y = arg<FL_VALUE_TYPE_FLOAT, int>(args, 4),
-                .width = arg<FL_VALUE_TYPE_FLOAT, int>(args, 5),
-                .height = arg<FL_VALUE_TYPE_FLOAT, int>(args, 6)},
-            .anchor = arg<FL_VALUE_TYPE_INT, mir_positioner_v1_anchor>(args, 7),
-            .gravity = gravity,
-            .offset = {
-                .dx = arg<FL_VALUE_TYPE_FLOAT, int>(args, 9),
-                .dy = arg<FL_VALUE_TYPE_FLOAT, int>(args, 10)},
-            .constraint_adjustment = arg<FL_VALUE_TYPE_INT, uint32_t>(args, 11)
-        };
+        auto const positioner{positioner_arg(args, 3)};
 
         if (!self->windows.contains(parent_id))
         {
@@ -333,14 +475,62 @@ static void mir_window_method_cb(FlMethodChannel* /*channel*/, FlMethodCall* met
                     return MirWindowArchetype::tip;
                 return MirWindowArchetype::satellite;
             }()};
-        MirWindow* const mir_window{mir_window_new(archetype, size, positioner, parent_mir_window, new_id)};
-        self->windows[mir_window->id] = mir_window;
-        gtk_window_set_application(GTK_WINDOW(mir_window), GTK_APPLICATION(self));
-        gtk_widget_show(GTK_WIDGET(mir_window));
+        MirWindow* mir_window{archetype != MirWindowArchetype::satellite ?
+            mfa::WindowPool::instance().acquire(archetype, size) :
+            nullptr};
+        if (mir_window)
+        {
+            mir_window_reset(mir_window, size, positioner, parent_mir_window, new_id);
+            self->windows[mir_window->id] = mir_window;
+            gtk_window_set_application(GTK_WINDOW(mir_window), GTK_APPLICATION(self));
+            mfa::Globals::instance().reuse_popup_window(mir_window);
+        }
+        else
+        {
+            mir_window = mir_window_new(archetype, size, positioner, parent_mir_window, new_id);
+            self->windows[mir_window->id] = mir_window;
+            gtk_window_set_application(GTK_WINDOW(mir_window), GTK_APPLICATION(self));
+            mir_window_present(mir_window);
+        }
 
         g_autoptr(FlValue) result{fl_value_new_int(mir_window->id)};
         fl_method_call_respond_success(method_call, result, nullptr);
     }
+    else if (name == "repositionWindow")
+    {
+        FlValue* const args{fl_method_call_get_args(method_call)};
+        if (fl_value_get_type(args) != FL_VALUE_TYPE_LIST || fl_value_get_length(args) != 10 ||
+            fl_value_get_type(fl_value_get_list_value(args, 0)) != FL_VALUE_TYPE_INT ||
+            fl_value_get_type(fl_value_get_list_value(args, 1)) != FL_VALUE_TYPE_FLOAT ||
+            fl_value_get_type(fl_value_get_list_value(args, 2)) != FL_VALUE_TYPE_FLOAT ||
+            fl_value_get_type(fl_value_get_list_value(args, 3)) != FL_VALUE_TYPE_FLOAT ||
+            fl_value_get_type(fl_value_get_list_value(args, 4)) != FL_VALUE_TYPE_FLOAT ||
+            fl_value_get_type(fl_value_get_list_value(args, 5)) != FL_VALUE_TYPE_INT ||
+            fl_value_get_type(fl_value_get_list_value(args, 6)) != FL_VALUE_TYPE_INT ||
+            fl_value_get_type(fl_value_get_list_value(args, 7)) != FL_VALUE_TYPE_FLOAT ||
+            fl_value_get_type(fl_value_get_list_value(args, 8)) != FL_VALUE_TYPE_FLOAT ||
+            fl_value_get_type(fl_value_get_list_value(args, 9)) != FL_VALUE_TYPE_INT)
+        {
+            fl_method_call_respond_error(method_call, "Bad Arguments", "", nullptr, nullptr);
+            return;
+        }
+
+        auto const window_id{arg<FL_VALUE_TYPE_INT, int>(args, 0)};
+        if (!self->windows.contains(window_id) ||
+            (self->windows[window_id]->archetype != MirWindowArchetype::satellite &&
+             self->windows[window_id]->archetype != MirWindowArchetype::popup &&
+             self->windows[window_id]->archetype != MirWindowArchetype::tip))
+        {
+            fl_method_call_respond_error(method_call, "Bad Arguments", "", nullptr, nullptr);
+            return;
+        }
+
+        MirWindow* const mir_window{self->windows[window_id]};
+        mir_window->positioner = positioner_arg(args, 1);
+        mfa::Globals::instance().reposition_window(mir_window);
+
+        fl_method_call_respond_success(method_call, nullptr, nullptr);
+    }
     else if (name == "createDialogWindow")
     {
         FlValue* const args{fl_method_call_get_args(method_call)};
@@ -368,7 +558,7 @@ static void mir_window_method_cb(FlMethodChannel* /*channel*/, FlMethodCall* met
         MirWindow* const mir_window{mir_window_new(MirWindowArchetype::dialog, size, {}, parent_mir_window, new_id)};
         self->windows[mir_window->id] = mir_window;
         gtk_window_set_application(GTK_WINDOW(mir_window), GTK_APPLICATION(self));
-        gtk_widget_show(GTK_WIDGET(mir_window));
+        mir_window_present(mir_window);
 
         g_autoptr(FlValue) result{fl_value_new_int(mir_window->id)};
         fl_method_call_respond_success(method_call, result, nullptr);
@@ -391,7 +581,15 @@ static void mir_window_method_cb(FlMethodChannel* /*channel*/, FlMethodCall* met
         }
 
         MirWindow* const mir_window{self->windows[window_id]};
-        mfa::Globals::instance().close_window(mir_window->surface);
+        if (mir_window->surface)
+        {
+            mfa::Globals::instance().close_window(mir_window->surface);
+        }
+        else
+        {
+            // Still waiting for the Wayland globals to be bound
+            gtk_widget_destroy(GTK_WIDGET(mir_window));
+        }
     }
     else if (name == "getWindowType")
     {
@@ -445,18 +643,106 @@ static void mir_window_method_cb(FlMethodChannel* /*channel*/, FlMethodCall* met
 
         MirWindow* const mir_window{self->windows[window_id]};
 
-        auto const width{std::holds_alternative<std::unique_ptr<mfa::XdgToplevelWindow>>(mir_window->window) ?
-            std::get<std::unique_ptr<mfa::XdgToplevelWindow>>(mir_window->window)->width() :
-            std::get<std::unique_ptr<mfa::XdgPopupWindow>>(mir_window->window)->width()};
-        auto const height{std::holds_alternative<std::unique_ptr<mfa::XdgToplevelWindow>>(mir_window->window) ?
-            std::get<std::unique_ptr<mfa::XdgToplevelWindow>>(mir_window->window)->height() :
-            std::get<std::unique_ptr<mfa::XdgPopupWindow>>(mir_window->window)->height()};
+        // Windows requested before the Wayland globals are bound are not created yet
+        auto const [width, height]{std::visit([mir_window](auto const& window)
+            {
+                return window ?
+                    std::pair{window->width(), window->height()} :
+                    std::pair{mir_window->size.width, mir_window->size.height};
+            }, mir_window->window)};
 
         g_autoptr(FlValue) result{fl_value_new_map()};
         fl_value_set(result, fl_value_new_string("width"), fl_value_new_float(width));
         fl_value_set(result, fl_value_new_string("height"), fl_value_new_float(height));
         fl_method_call_respond_success(method_call, result, nullptr);
     }
+    else if (name == "getStats")
+    {
+        auto const& stats{mfa::Stats::instance()};
+
+        g_autoptr(FlValue) result{fl_value_new_map()};
+        for (size_t i{0}; i < mfa::Stats::counter_count; ++i)
+        {
+            auto const counter{static_cast<mfa::Stats::Counter>(i)};
+            fl_value_set_string_take(result, mfa::Stats::name(counter), fl_value_new_int(stats.value(counter)));
+        }
+        for (size_t i{0}; i < mfa::Stats::histogram_count; ++i)
+        {
+            auto const histogram{static_cast<mfa::Stats::Histogram>(i)};
+            auto const values{stats.values(histogram)};
+
+            FlValue* const buckets{fl_value_new_list()};
+            for (auto const bucket : values.buckets)
+            {
+                fl_value_append_take(buckets, fl_value_new_int(bucket));
+            }
+
+            FlValue* const entry{fl_value_new_map()};
+            fl_value_set_string_take(entry, "count", fl_value_new_int(values.count));
+            fl_value_set_string_take(entry, "sumUs", fl_value_new_int(values.sum_us));
+            fl_value_set_string_take(entry, "buckets", buckets);
+            fl_value_set_string_take(result, mfa::Stats::name(histogram), entry);
+        }
+        fl_method_call_respond_success(method_call, result, nullptr);
+    }
+    else if (name == "getMemoryUsage")
+    {
+        auto const& budget{mfa::MemoryBudget::instance()};
+
+        FlValue* const windows{fl_value_new_map()};
+        for (auto const& [id, mir_window] : self->windows)
+        {
+            auto const [buffers, bytes]{std::visit([](auto const& window)
+                {
+                    return window ? std::pair{window->buffer_count(), window->buffer_bytes()} : std::pair{0, size_t{0}};
+                }, mir_window->window)};
+
+            FlValue* const entry{fl_value_new_map()};
+            fl_value_set_string_take(entry, "buffers", fl_value_new_int(buffers));
+            fl_value_set_string_take(entry, "bufferBytes", fl_value_new_int(bytes));
+            fl_value_set_take(windows, fl_value_new_int(id), entry);
+        }
+
+        g_autoptr(FlValue) result{fl_value_new_map()};
+        fl_value_set_string_take(result, "budget", fl_value_new_int(budget.budget()));
+        fl_value_set_string_take(result, "used", fl_value_new_int(budget.used()));
+        fl_value_set_string_take(result, "windows", windows);
+        fl_method_call_respond_success(method_call, result, nullptr);
+    }
+    else if (name == "writeTrace")
+    {
+        auto const& tracer{mfa::Tracer::instance()};
+        if (!tracer.enabled() || !tracer.write())
+        {
+            fl_method_call_respond_error(
+                method_call,
+                "Tracing Unavailable",
+                "Set MIR_FLUTTER_APP_TRACE to a writable path to enable tracing",
+                nullptr,
+                nullptr);
+            return;
+        }
+
+        g_autoptr(FlValue) result{fl_value_new_string(tracer.path().c_str())};
+        fl_method_call_respond_success(method_call, result, nullptr);
+    }
+    else if (name == "replayEvents")
+    {
+        FlValue* const args{fl_method_call_get_args(method_call)};
+        if (fl_value_get_type(args) != FL_VALUE_TYPE_LIST || fl_value_get_length(args) != 1 ||
+            fl_value_get_type(fl_value_get_list_value(args, 0)) != FL_VALUE_TYPE_STRING)
+        {
+            fl_method_call_respond_error(method_call, "Bad Arguments", "", nullptr, nullptr);
+            return;
+        }
+
+        if (!mfa::EventReplayer::start(fl_value_get_string(fl_value_get_list_value(args, 0))))
+        {
+            fl_method_call_respond_error(method_call, "Bad Recording", "", nullptr, nullptr);
+            return;
+        }
+        fl_method_call_respond_success(method_call, nullptr, nullptr);
+    }
     else
     {
         fl_method_call_respond_not_implemented(method_call, nullptr);
@@ -470,8 +756,6 @@ static void my_application_activate(GApplication* application)
     self->main_window = GTK_WINDOW(gtk_application_window_new(GTK_APPLICATION(application)));
     gtk_window_set_title(self->main_window, "mir_flutter_app");
 
-    self->windows = {};
-
     gtk_window_set_default_size(self->main_window, MAIN_WINDOW_WIDTH, MAIN_WINDOW_HEIGHT);
     gtk_widget_show(GTK_WIDGET(self->main_window));
 
@@ -479,29 +763,61 @@ static void my_application_activate(GApplication* application)
     GdkDisplay* const gdk_display{gdk_window_get_display(gdk_window)};
     if (!GDK_IS_WAYLAND_DISPLAY(gdk_display))
     {
-        std::cerr << "This application requires a Wayland display.\n";
+        MFA_LOG(error, "app", "This application requires a Wayland display");
         std::abort();
     }
     wl_display* const display{gdk_wayland_display_get_wl_display(gdk_display)};
     if (!display)
     {
-        std::cerr << "Failed to bind to wl_display.\n";
+        MFA_LOG(error, "app", "Failed to bind to wl_display");
         std::abort();
     }
 
     mfa::Globals::instance().bind_interfaces(display);
 
+    if (std::getenv("MIR_FLUTTER_APP_PREWARM"))
+    {
+        // Left for when the main loop is idle, so it does not hold up the Flutter view
+        mfa::Globals::instance().when_ready([]
+            {
+                g_idle_add(
+                    [](gpointer) -> gboolean
+                    {
+                        mfa::Globals::instance().prewarm();
+                        return G_SOURCE_REMOVE;
+                    },
+                    nullptr);
+            });
+    }
+
+    g_unix_signal_add(
+        SIGUSR1,
+        [](gpointer) -> gboolean
+        {
+            mfa::Stats::instance().dump(std::cout);
+            return G_SOURCE_CONTINUE;
+        },
+        nullptr);
+
     g_autoptr(FlDartProject) project{fl_dart_project_new()};
     fl_dart_project_set_dart_entrypoint_arguments(project, self->dart_entrypoint_arguments);
 
+    auto const view_creation_started{std::chrono::steady_clock::now()};
+    mfa::Tracer::instance().begin("fl_view_new");
     FlView* const view{fl_view_new(project)};
+    mfa::Tracer::instance().end("fl_view_new");
+    std::chrono::duration<double, std::milli> const view_creation{
+        std::chrono::steady_clock::now() - view_creation_started};
+    MFA_LOG(info, "app", "Created Flutter view in ", view_creation.count(), " ms");
     gtk_widget_show(GTK_WIDGET(view));
     gtk_container_add(GTK_CONTAINER(self->main_window), GTK_WIDGET(view));
+    g_signal_connect(
+        view,
+        "first-frame",
+        G_CALLBACK(+[](FlView*) { mfa::Tracer::instance().instant("first Flutter frame"); }),
+        nullptr);
 
-    FlBinaryMessenger* const messenger{fl_engine_get_binary_messenger(fl_view_get_engine(view))};
-    g_autoptr(FlStandardMethodCodec) codec{fl_standard_method_codec_new()};
-    self->mir_window_channel = fl_method_channel_new(messenger, CHANNEL, FL_METHOD_CODEC(codec));
-    fl_method_channel_set_method_call_handler(self->mir_window_channel, mir_window_method_cb, self, nullptr);
+    my_application_handle_window_calls(self, fl_engine_get_binary_messenger(fl_view_get_engine(view)));
 
     fl_register_plugins(FL_PLUGIN_REGISTRY(view));
 
@@ -559,3 +875,13 @@ MyApplication* my_application_new()
         G_APPLICATION_NON_UNIQUE,
         nullptr));
 }
+
+void my_application_handle_window_calls(MyApplication* self, FlBinaryMessenger* messenger)
+{
+    self->windows = {};
+    mfa::WindowPool::instance().set_release_handler(mir_window_closed);
+
+    g_autoptr(FlStandardMethodCodec) codec{fl_standard_method_codec_new()};
+    self->mir_window_channel = fl_method_channel_new(messenger, CHANNEL, FL_METHOD_CODEC(codec));
+    fl_method_channel_set_method_call_handler(self->mir_window_channel, mir_window_method_cb, self, nullptr);
+}
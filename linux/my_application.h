@@ -1,6 +1,7 @@
 #ifndef FLUTTER_MY_APPLICATION_H_
 #define FLUTTER_MY_APPLICATION_H_
 
+#include <flutter_linux/flutter_linux.h>
 #include <gtk/gtk.h>
 
 G_DECLARE_FINAL_TYPE(MyApplication, my_application, MY, APPLICATION, GtkApplication)
@@ -14,4 +15,15 @@ G_DECLARE_FINAL_TYPE(MyApplication, my_application, MY, APPLICATION, GtkApplicat
  */
 MyApplication* my_application_new();
 
+/**
+ * my_application_handle_window_calls:
+ * @self: a #MyApplication.
+ * @messenger: the #FlBinaryMessenger the window method calls come from.
+ *
+ * Handles the calls on the window channel of the messenger, as the application
+ * does with the messenger of its Flutter engine once activated. The
+ * application must be registered, and the Wayland globals bound.
+ */
+void my_application_handle_window_calls(MyApplication* self, FlBinaryMessenger* messenger);
+
 #endif // FLUTTER_MY_APPLICATION_H_
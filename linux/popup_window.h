@@ -15,7 +15,7 @@ protected:
     void handle_mouse_button(wl_pointer* pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state)
         override;
 
-    void draw_new_content(Buffer* buffer) override;
+    auto content_painter() const -> Painter override;
 
     PopupWindow(PopupWindow&&) = default;
     PopupWindow& operator=(PopupWindow&&) = default;
@@ -0,0 +1,60 @@
+#ifndef POSITIONER_CACHE_H_
+#define POSITIONER_CACHE_H_
+
+#include "stats.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace mir_flutter_app
+{
+// Anchor rectangle, anchor, gravity, offset, constraint adjustment, and size of a placement
+using PositionerKey = std::array<int64_t, 11>;
+
+// Keeps the most recently used positioners, already configured, so windows placed alike (such as the same menu or
+// tooltip shown again) reuse them instead of creating and configuring new ones. A positioner can be used for any
+// number of requests, since only its state at the time of each request matters. The least recently used one is
+// destroyed when the cache is full.
+template<typename Positioner>
+class PositionerCache
+{
+public:
+    // Returns the positioner cached for the key, or the one make returns, which is then cached. The cache keeps
+    // ownership of the positioners it returns.
+    template<typename Make>
+    auto get(PositionerKey const& key, Make&& make, void (*destroy)(Positioner*)) -> Positioner*
+    {
+        auto const entry{std::find_if(
+            entries.begin(),
+            entries.end(),
+            [&key](auto const& cached) { return cached.first == key; })};
+        if (entry != entries.end())
+        {
+            Stats::instance().increment(Stats::Counter::positioners_reused);
+            std::rotate(entries.begin(), entry, entry + 1);
+            return entries.front().second;
+        }
+
+        if (entries.size() == capacity)
+        {
+            destroy(entries.back().second);
+            entries.pop_back();
+        }
+        Stats::instance().increment(Stats::Counter::positioners_created);
+        entries.emplace(entries.begin(), key, make());
+        return entries.front().second;
+    }
+
+private:
+    static size_t const capacity{16};
+
+    // Most recently used first
+    std::vector<std::pair<PositionerKey, Positioner*>> entries;
+};
+}
+
+#endif // POSITIONER_CACHE_H_
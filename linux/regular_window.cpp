@@ -10,7 +10,7 @@
 namespace mfa = mir_flutter_app;
 
 mfa::RegularWindow::RegularWindow(wl_surface* surface, int32_t width, int32_t height) :
-    DecoratedXdgToplevelWindow{surface, width, height, {.title_bar_text = "regular"}},
+    DecoratedXdgToplevelWindow{surface, width, height, {.title_bar_text = "regular", .title_bar_on_subsurface = true}},
     mir_regular_surface{
         Globals::instance().mir_shell() ?
         mir_shell_v1_get_regular_surface(Globals::instance().mir_shell(), surface) :
@@ -70,22 +70,26 @@ void mfa::RegularWindow::handle_keyboard_modifiers(
     modifiers = mods_depressed;
 }
 
-void mfa::RegularWindow::draw_new_content(Buffer* buffer)
+auto mfa::RegularWindow::content_painter() const -> Painter
 {
-    DecoratedXdgToplevelWindow::draw_new_content(buffer);
+    return [decorations{DecoratedXdgToplevelWindow::content_painter()}, title_bar_height{config().title_bar_height}](
+            Buffer* buffer)
+        {
+            decorations(buffer);
 
-    std::string text{"Hello, Mir Shell!"};
-    cairo_set_source_rgb(buffer->cairo_context, 0.2, 0.2, 0.2);
-    cairo_select_font_face(buffer->cairo_context, "Ubuntu", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-    cairo_set_font_size(buffer->cairo_context, 24);
+            std::string text{"Hello, Mir Shell!"};
+            cairo_set_source_rgb(buffer->cairo_context, 0.2, 0.2, 0.2);
+            cairo_select_font_face(buffer->cairo_context, "Ubuntu", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+            cairo_set_font_size(buffer->cairo_context, 24);
 
-    cairo_text_extents_t text_extents;
-    cairo_text_extents(buffer->cairo_context, text.c_str(), &text_extents);
+            cairo_text_extents_t text_extents;
+            cairo_text_extents(buffer->cairo_context, text.c_str(), &text_extents);
 
-    cairo_move_to(
-        buffer->cairo_context,
-        (buffer->width - text_extents.width) / 2.0 - text_extents.x_bearing,
-        (config().title_bar_height + buffer->height - text_extents.height) / 2.0 - text_extents.y_bearing);
+            cairo_move_to(
+                buffer->cairo_context,
+                (buffer->width - text_extents.width) / 2.0 - text_extents.x_bearing,
+                (title_bar_height + buffer->height - text_extents.height) / 2.0 - text_extents.y_bearing);
 
-    cairo_show_text(buffer->cairo_context, text.c_str());
+            cairo_show_text(buffer->cairo_context, text.c_str());
+        };
 }
@@ -24,7 +24,7 @@ protected:
         uint32_t mods_locked,
         uint32_t group) override;
 
-    void draw_new_content(Buffer* buffer) override;
+    auto content_painter() const -> Painter override;
 
     RegularWindow(RegularWindow&&) = default;
     RegularWindow& operator=(RegularWindow&&) = default;
@@ -0,0 +1,103 @@
+#include "render_thread.h"
+#include "logger.h"
+
+#include <glib-unix.h>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+namespace mfa = mir_flutter_app;
+
+mfa::RenderThread::RenderThread() :
+    wakeup_fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)}
+{
+    if (wakeup_fd < 0)
+    {
+        MFA_LOG(error, "render", "Failed to create the render thread wakeup fd");
+        std::abort();
+    }
+
+    wakeup_source = g_unix_fd_add(
+        wakeup_fd,
+        G_IO_IN,
+        [](gint /*fd*/, GIOCondition /*condition*/, gpointer ctx) -> gboolean
+        {
+            static_cast<RenderThread*>(ctx)->present_drawn_frames();
+            return G_SOURCE_CONTINUE;
+        },
+        this);
+
+    thread = std::thread{[this] { run(); }};
+}
+
+mfa::RenderThread::~RenderThread()
+{
+    stopping = true;
+    ++last_submitted;
+    last_submitted.notify_one();
+    thread.join();
+
+    g_source_remove(wakeup_source);
+    close(wakeup_fd);
+}
+
+auto mfa::RenderThread::submit(std::function<void()> draw, std::function<void()> present) -> uint64_t
+{
+    if (frames_in_flight == max_frames_in_flight) return 0;
+
+    auto const token{last_submitted.load() + 1};
+    submitted_frames.push({.token = token, .draw = std::move(draw), .present = std::move(present)});
+    ++frames_in_flight;
+
+    last_submitted = token;
+    last_submitted.notify_one();
+    return token;
+}
+
+void mfa::RenderThread::cancel(uint64_t frame, std::function<void()> cancelled)
+{
+    cancelled_frames.emplace(frame, std::move(cancelled));
+}
+
+void mfa::RenderThread::run()
+{
+    while (true)
+    {
+        last_submitted.wait(last_drawn);
+        if (stopping) return;
+
+        while (auto frame{submitted_frames.pop()})
+        {
+            frame->draw();
+
+            // Cannot fail: the main thread never has more frames in flight than either queue holds
+            auto const token{frame->token};
+            drawn_frames.push(std::move(*frame));
+
+            last_drawn = token;
+
+            uint64_t const one{1};
+            [[maybe_unused]] auto const written{write(wakeup_fd, &one, sizeof(one))};
+        }
+    }
+}
+
+void mfa::RenderThread::present_drawn_frames()
+{
+    uint64_t count;
+    [[maybe_unused]] auto const read_{read(wakeup_fd, &count, sizeof(count))};
+
+    while (auto frame{drawn_frames.pop()})
+    {
+        --frames_in_flight;
+        if (auto cancelled{cancelled_frames.extract(frame->token)})
+        {
+            if (cancelled.mapped()) cancelled.mapped()();
+            continue;
+        }
+
+        frame->present();
+    }
+}
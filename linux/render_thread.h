@@ -0,0 +1,70 @@
+#ifndef RENDER_THREAD_H_
+#define RENDER_THREAD_H_
+
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <thread>
+
+namespace mir_flutter_app
+{
+// Draws window contents away from the GLib main loop. Frames are submitted from the main thread, drawn in
+// order on the render thread, and handed back to the main loop to be attached and committed.
+class RenderThread
+{
+public:
+    RenderThread(RenderThread const&) = delete;
+    RenderThread(RenderThread&&) = delete;
+    RenderThread& operator=(RenderThread const&) = delete;
+    RenderThread& operator=(RenderThread&&) = delete;
+    ~RenderThread();
+
+    static RenderThread& instance()
+    {
+        static RenderThread instance;
+        return instance;
+    }
+
+    // Runs draw on the render thread, then present on the main thread. Returns a token identifying the frame, or
+    // 0 if too many frames are in flight, in which case neither function is called.
+    auto submit(std::function<void()> draw, std::function<void()> present) -> uint64_t;
+
+    // Drops the frame without presenting it. It may still be drawn, so cancelled is called on the main thread
+    // instead of present once it is, to release what the frame was drawn into.
+    void cancel(uint64_t frame, std::function<void()> cancelled);
+
+private:
+    struct Frame
+    {
+        uint64_t token{};
+        std::function<void()> draw;
+        std::function<void()> present;
+    };
+
+    static size_t const max_frames_in_flight{64};
+
+    SpscQueue<Frame, max_frames_in_flight> submitted_frames;
+    SpscQueue<Frame, max_frames_in_flight> drawn_frames;
+    std::atomic<uint64_t> last_submitted{};
+    std::atomic<uint64_t> last_drawn{};
+    std::atomic<bool> stopping{};
+
+    // Only used on the main thread
+    size_t frames_in_flight{};
+    std::map<uint64_t, std::function<void()>> cancelled_frames;
+
+    int wakeup_fd;
+    unsigned int wakeup_source;
+    std::thread thread;
+
+    void run();
+    void present_drawn_frames();
+
+    RenderThread();
+};
+}
+
+#endif // RENDER_THREAD_H_
@@ -0,0 +1,58 @@
+#include "reposition_requests.h"
+#include "logger.h"
+#include "stats.h"
+#include "tracer.h"
+
+namespace mfa = mir_flutter_app;
+
+auto mfa::RepositionRequests::request(int window_id) -> uint32_t
+{
+    if (in_flight)
+    {
+        Stats::instance().increment(Stats::Counter::coalesced_repositions);
+        pending = true;
+        return 0;
+    }
+
+    return next_token(window_id);
+}
+
+auto mfa::RepositionRequests::handle_repositioned(uint32_t token, int window_id) -> uint32_t
+{
+    // Only the latest token is in flight, as the others were coalesced before being sent
+    if (!in_flight || token != last_token) return 0;
+
+    auto const latency{std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sent)};
+    MFA_LOG(debug, "xdg", "Window ", window_id, " - Repositioned (token ", token, ") in ", latency.count(), " us");
+    Stats::instance().record(Stats::Histogram::reposition_time, latency);
+    Tracer::instance().end_async("reposition", window_id);
+
+    in_flight = false;
+    return pending ? next_token(window_id) : 0;
+}
+
+void mfa::RepositionRequests::cancel()
+{
+    if (in_flight)
+    {
+        Tracer::instance().end_async("reposition", sent_for);
+    }
+
+    // The last token is kept, so a late answer to the cancelled request is not taken for the next one
+    in_flight = false;
+    pending = false;
+}
+
+auto mfa::RepositionRequests::next_token(int window_id) -> uint32_t
+{
+    // Tokens start at 1, so 0 can mean that there is nothing to send
+    if (++last_token == 0) ++last_token;
+
+    in_flight = true;
+    pending = false;
+    sent = std::chrono::steady_clock::now();
+    sent_for = window_id;
+    Stats::instance().increment(Stats::Counter::repositions);
+    Tracer::instance().begin_async("reposition", window_id);
+    return last_token;
+}
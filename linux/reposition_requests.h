@@ -0,0 +1,35 @@
+#ifndef REPOSITION_REQUESTS_H_
+#define REPOSITION_REQUESTS_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace mir_flutter_app
+{
+// Keeps at most one reposition request of a window in flight. Requests made meanwhile, such as when following a
+// dragged anchor, are coalesced into a single one that is sent once the compositor has applied the previous one.
+// The time each request takes to be applied is recorded in the reposition_time histogram.
+class RepositionRequests
+{
+public:
+    // Returns the token to send a request with right away, or 0 if it is coalesced into the one in flight
+    auto request(int window_id) -> uint32_t;
+    // Returns the token to send the coalesced request with, or 0 if there is none
+    auto handle_repositioned(uint32_t token, int window_id) -> uint32_t;
+    // Drops the request in flight and the coalesced one, which will not be answered, such as when the popup is
+    // dismissed. The next request is sent right away.
+    void cancel();
+
+private:
+    uint32_t last_token{};
+    bool in_flight{};
+    bool pending{};
+    std::chrono::steady_clock::time_point sent;
+    // Window the request in flight was made for
+    int sent_for{};
+
+    auto next_token(int window_id) -> uint32_t;
+};
+}
+
+#endif // REPOSITION_REQUESTS_H_
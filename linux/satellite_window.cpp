@@ -1,11 +1,12 @@
 #include "satellite_window.h"
+#include "event_recorder.h"
 #include "globals.h"
+#include "mir_window.h"
 #include "mir-shell.h"
 #include "xdg-shell.h"
 
 #include <linux/input-event-codes.h>
 
-#include <iostream>
 
 namespace mfa = mir_flutter_app;
 
@@ -20,7 +21,9 @@ mfa::SatelliteWindow::SatelliteWindow(
             .title_bar_text = "satellite",
             .title_bar_corner_radius = 8,
             .title_bar_height = 24,
-            .title_bar_font_size = 13
+            .title_bar_font_size = 13,
+            .minimize_button = false,
+            .maximize_button = false
         }},
     mir_satellite_surface{
         Globals::instance().mir_shell() ?
@@ -66,9 +69,35 @@ void mfa::SatelliteWindow::handle_keyboard_key(
     }
 }
 
+void mfa::SatelliteWindow::reposition()
+{
+    if (!mir_satellite_surface) return;
+
+    auto* const window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
+    if (auto const token{reposition_requests.request(window->id)})
+    {
+        send_reposition(token);
+    }
+}
+
+void mfa::SatelliteWindow::send_reposition(uint32_t token)
+{
+    auto* const window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
+    mir_satellite_surface_v1_reposition(
+        mir_satellite_surface,
+        Globals::instance().mir_positioner_for(window->positioner),
+        token);
+}
+
 void mfa::SatelliteWindow::handle_repositioned(
     mir_satellite_surface_v1* /*mir_satellite_surface_v1*/,
-    uint32_t /*token*/)
+    uint32_t token)
 {
-    std::cout << "Received repositioned event" << std::endl;
+    auto* const window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
+    EventRecorder::instance().record(EventRecorder::Kind::repositioned, window->id, {token});
+
+    if (auto const next_token{reposition_requests.handle_repositioned(token, window->id)})
+    {
+        send_reposition(next_token);
+    }
 }
@@ -2,6 +2,7 @@
 #define SATELLITE_WINDOW_H_
 
 #include "decorated_xdg_toplevel_window.h"
+#include "reposition_requests.h"
 
 struct mir_positioner_v1;
 struct mir_satellite_surface_v1;
@@ -20,6 +21,9 @@ public:
         xdg_toplevel* parent);
     ~SatelliteWindow() override;
 
+    // Asks the compositor to place the window with the positioner of its MirWindow
+    void reposition();
+
 protected:
     void handle_keyboard_key(wl_keyboard* keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state)
         override;
@@ -30,6 +34,9 @@ protected:
 private:
     mir_satellite_surface_v1* mir_satellite_surface;
 
+    RepositionRequests reposition_requests;
+
+    void send_reposition(uint32_t token);
     void handle_repositioned(mir_satellite_surface_v1* mir_satellite_surface_v1, uint32_t token);
 
     SatelliteWindow(SatelliteWindow const&) = delete;
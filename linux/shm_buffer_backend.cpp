@@ -0,0 +1,66 @@
+#include "shm_buffer_backend.h"
+#include "globals.h"
+
+#include <wayland-client.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+auto make_shm_pool(wl_shm* shm, int size, void** data) -> wl_shm_pool*
+{
+    int fd{memfd_create("make_shm_pool", MFD_CLOEXEC)};
+    if (fd < 0) return nullptr;
+
+    posix_fallocate(fd, 0, size);
+
+    *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (*data == MAP_FAILED)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    wl_shm_pool* pool{wl_shm_create_pool(shm, fd, size)};
+
+    close(fd);
+
+    return pool;
+}
+}
+
+namespace mfa = mir_flutter_app;
+
+mfa::ShmBufferBackend::ShmBufferBackend(wl_shm* shm) :
+    shm{shm}
+{
+}
+
+auto mfa::ShmBufferBackend::supports_format(uint32_t format) const -> bool
+{
+    return Globals::instance().supports_shm_format(format);
+}
+
+auto mfa::ShmBufferBackend::allocate(int32_t width, int32_t height, uint32_t format) -> Memory
+{
+    auto const stride{width * 4};
+    auto const size{stride * height};
+
+    void* pool_data;
+    wl_shm_pool* shm_pool{make_shm_pool(shm, size, &pool_data)};
+    if (!shm_pool) return {};
+
+    auto* const buffer{wl_shm_pool_create_buffer(shm_pool, 0, width, height, stride, format)};
+    wl_shm_pool_destroy(shm_pool);
+
+    return {.buffer = buffer, .data = pool_data, .stride = stride, .size = static_cast<size_t>(size)};
+}
+
+void mfa::ShmBufferBackend::destroy(Memory& memory)
+{
+    if (memory.buffer) wl_buffer_destroy(memory.buffer);
+    if (memory.data) munmap(memory.data, memory.size);
+    memory = {};
+}
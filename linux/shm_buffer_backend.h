@@ -0,0 +1,24 @@
+#ifndef SHM_BUFFER_BACKEND_H_
+#define SHM_BUFFER_BACKEND_H_
+
+#include "buffer_backend.h"
+
+struct wl_shm;
+
+namespace mir_flutter_app
+{
+class ShmBufferBackend : public BufferBackend
+{
+public:
+    explicit ShmBufferBackend(wl_shm* shm);
+
+    auto supports_format(uint32_t format) const -> bool override;
+    auto allocate(int32_t width, int32_t height, uint32_t format) -> Memory override;
+    void destroy(Memory& memory) override;
+
+private:
+    wl_shm* shm;
+};
+}
+
+#endif // SHM_BUFFER_BACKEND_H_
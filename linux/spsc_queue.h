@@ -0,0 +1,47 @@
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace mir_flutter_app
+{
+// Fixed-capacity lock-free queue between exactly one producer thread and one consumer thread
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+public:
+    // Called by the producer. Fails if the queue is full.
+    auto push(T&& value) -> bool
+    {
+        auto const current_tail{tail.load(std::memory_order_relaxed)};
+        if (current_tail - head.load(std::memory_order_acquire) == Capacity) return false;
+
+        slots[current_tail % Capacity] = std::move(value);
+        tail.store(current_tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Called by the consumer
+    auto pop() -> std::optional<T>
+    {
+        auto const current_head{head.load(std::memory_order_relaxed)};
+        if (current_head == tail.load(std::memory_order_acquire)) return std::nullopt;
+
+        std::optional<T> value{std::move(slots[current_head % Capacity])};
+        head.store(current_head + 1, std::memory_order_release);
+        return value;
+    }
+
+private:
+    std::array<T, Capacity> slots{};
+
+    // Kept on separate cache lines so the two threads do not contend over them
+    alignas(64) std::atomic<size_t> head{};
+    alignas(64) std::atomic<size_t> tail{};
+};
+}
+
+#endif // SPSC_QUEUE_H_
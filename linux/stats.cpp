@@ -0,0 +1,144 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+
+namespace
+{
+char const* const counter_names[]{
+    "redraws",
+    "coalesced_redraws",
+    "bytes_drawn",
+    "no_free_buffer",
+    "buffer_allocations",
+    "frame_callbacks",
+    "configures",
+    "method_calls",
+    "repositions",
+    "coalesced_repositions",
+    "positioners_created",
+    "positioners_reused",
+    "window_pool_hits",
+    "window_pool_misses",
+    "back_buffer_bytes_dropped",
+    "hidden_bytes_released",
+};
+static_assert(std::size(counter_names) == mir_flutter_app::Stats::counter_count);
+
+char const* const histogram_names[]{
+    "draw_time",
+    "method_call_time",
+    "create_window_time",
+    "close_window_time",
+    "query_window_time",
+    "reposition_time",
+    "first_commit_time",
+};
+static_assert(std::size(histogram_names) == mir_flutter_app::Stats::histogram_count);
+}
+
+namespace mfa = mir_flutter_app;
+
+mfa::Stats::Timer::~Timer()
+{
+    Stats::instance().record(
+        histogram,
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+}
+
+auto mfa::Stats::name(Counter counter) -> char const*
+{
+    return counter_names[static_cast<size_t>(counter)];
+}
+
+auto mfa::Stats::name(Histogram histogram) -> char const*
+{
+    return histogram_names[static_cast<size_t>(histogram)];
+}
+
+void mfa::Stats::increment(Counter counter)
+{
+    add(counter, 1);
+}
+
+void mfa::Stats::add(Counter counter, uint64_t amount)
+{
+    shard().counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void mfa::Stats::record(Histogram histogram, std::chrono::microseconds value)
+{
+    auto const us{static_cast<uint64_t>(std::max(value.count(), std::chrono::microseconds::rep{0}))};
+    auto const bucket{std::min(static_cast<size_t>(std::bit_width(us)), bucket_count - 1)};
+
+    auto& histogram_shard{shard().histograms[static_cast<size_t>(histogram)]};
+    histogram_shard.count.fetch_add(1, std::memory_order_relaxed);
+    histogram_shard.sum_us.fetch_add(us, std::memory_order_relaxed);
+    histogram_shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+auto mfa::Stats::value(Counter counter) const -> uint64_t
+{
+    uint64_t total{};
+    for (auto const& shard : shards)
+    {
+        total += shard.counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+auto mfa::Stats::values(Histogram histogram) const -> HistogramValues
+{
+    HistogramValues total;
+    for (auto const& shard : shards)
+    {
+        auto const& histogram_shard{shard.histograms[static_cast<size_t>(histogram)]};
+        total.count += histogram_shard.count.load(std::memory_order_relaxed);
+        total.sum_us += histogram_shard.sum_us.load(std::memory_order_relaxed);
+        for (size_t i{0}; i < bucket_count; ++i)
+        {
+            total.buckets[i] += histogram_shard.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+void mfa::Stats::dump(std::ostream& out) const
+{
+    for (size_t i{0}; i < counter_count; ++i)
+    {
+        out << std::setw(28) << std::left << counter_names[i] << value(static_cast<Counter>(i)) << '\n';
+    }
+
+    for (size_t i{0}; i < histogram_count; ++i)
+    {
+        auto const histogram{values(static_cast<Histogram>(i))};
+        out << std::setw(28) << std::left << histogram_names[i] << histogram.count << " samples, mean "
+            << (histogram.count ? histogram.sum_us / histogram.count : 0) << " us\n";
+
+        for (size_t bucket{0}; bucket < bucket_count; ++bucket)
+        {
+            if (!histogram.buckets[bucket]) continue;
+
+            out << "    < " << std::setw(10) << std::right;
+            if (bucket + 1 < bucket_count)
+            {
+                out << (uint64_t{1} << bucket);
+            }
+            else
+            {
+                out << "inf";
+            }
+            out << " us: " << histogram.buckets[bucket] << '\n';
+        }
+    }
+    out.flush();
+}
+
+auto mfa::Stats::shard() -> Shard&
+{
+    static std::atomic<size_t> next_shard{};
+    thread_local auto const index{next_shard++ % shard_count};
+    return shards[index];
+}
@@ -0,0 +1,125 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace mir_flutter_app
+{
+// Counters and latency histograms for the runner's hot paths. Updates are lock-free: each thread updates its
+// own shard, and readers add the shards up.
+class Stats
+{
+public:
+    enum class Counter
+    {
+        redraws,
+        coalesced_redraws,
+        bytes_drawn,
+        no_free_buffer,
+        buffer_allocations,
+        frame_callbacks,
+        configures,
+        method_calls,
+        repositions,
+        coalesced_repositions,
+        positioners_created,
+        positioners_reused,
+        window_pool_hits,
+        window_pool_misses,
+        back_buffer_bytes_dropped,
+        hidden_bytes_released,
+    };
+
+    enum class Histogram
+    {
+        draw_time,
+        method_call_time,
+        create_window_time,
+        close_window_time,
+        query_window_time,
+        reposition_time,
+        first_commit_time,
+    };
+
+    static size_t const counter_count{static_cast<size_t>(Counter::hidden_bytes_released) + 1};
+    static size_t const histogram_count{static_cast<size_t>(Histogram::first_commit_time) + 1};
+    // Bucket 0 holds values under 1 us, and bucket n values in [2^(n-1), 2^n) us. The last one is open-ended.
+    static size_t const bucket_count{24};
+
+    struct HistogramValues
+    {
+        uint64_t count{};
+        uint64_t sum_us{};
+        std::array<uint64_t, bucket_count> buckets{};
+    };
+
+    // Records the time from its construction to its destruction in a histogram
+    class Timer
+    {
+    public:
+        explicit Timer(Histogram histogram) : histogram{histogram}, start{std::chrono::steady_clock::now()} {}
+        ~Timer();
+
+        Timer(Timer const&) = delete;
+        Timer& operator=(Timer const&) = delete;
+
+    private:
+        Histogram histogram;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    Stats(Stats const&) = delete;
+    Stats(Stats&&) = delete;
+    Stats& operator=(Stats const&) = delete;
+    Stats& operator=(Stats&&) = delete;
+    ~Stats() = default;
+
+    static Stats& instance()
+    {
+        static Stats instance;
+        return instance;
+    }
+
+    static auto name(Counter counter) -> char const*;
+    static auto name(Histogram histogram) -> char const*;
+
+    void increment(Counter counter);
+    void add(Counter counter, uint64_t amount);
+    void record(Histogram histogram, std::chrono::microseconds value);
+
+    auto value(Counter counter) const -> uint64_t;
+    auto values(Histogram histogram) const -> HistogramValues;
+
+    void dump(std::ostream& out) const;
+
+private:
+    struct HistogramShard
+    {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum_us;
+        std::array<std::atomic<uint64_t>, bucket_count> buckets;
+    };
+
+    // Cache line aligned, so threads do not contend over each other's shards
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<uint64_t>, counter_count> counters;
+        std::array<HistogramShard, histogram_count> histograms;
+    };
+
+    static size_t const shard_count{8};
+
+    std::array<Shard, shard_count> shards{};
+
+    auto shard() -> Shard&;
+
+    Stats() = default;
+};
+}
+
+#endif // STATS_H_
@@ -0,0 +1,64 @@
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mir_flutter_app::test
+{
+// Number of times to repeat what is measured: the given count, or a handful when the benchmark is run with
+// --quick, as ctest does to make sure the benchmarks keep working
+inline auto iterations(int argc, char** argv, int count) -> int
+{
+    for (int i{1}; i < argc; ++i)
+    {
+        if (std::string_view{argv[i]} == "--quick") return std::min(count, 3);
+    }
+    return count;
+}
+
+// Wall-clock time since construction or the last restart
+class Stopwatch
+{
+public:
+    void restart() { start = std::chrono::steady_clock::now(); }
+
+    auto elapsed_ns() const -> double
+    {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+};
+
+// Value below which the given fraction of the samples fall. Sorts the samples.
+inline auto percentile(std::vector<double>& samples, double fraction) -> double
+{
+    if (samples.empty()) return 0;
+
+    std::sort(samples.begin(), samples.end());
+    auto const index{static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1))};
+    return samples[index];
+}
+
+// Prints one row of results, as the name of what was measured followed by its named values
+inline void report(std::string const& name, std::initializer_list<std::pair<char const*, double>> values)
+{
+    std::printf("%-40s", name.c_str());
+    for (auto const& [key, value] : values)
+    {
+        std::printf("  %s: %.1f", key, value);
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+}
+
+#endif // BENCHMARK_H_
@@ -0,0 +1,18 @@
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <cstdlib>
+#include <iostream>
+
+// Fails the test with the location of the condition that does not hold
+#define CHECK(condition)                                                                        \
+    do                                                                                          \
+    {                                                                                           \
+        if (!(condition))                                                                       \
+        {                                                                                       \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n";     \
+            std::exit(EXIT_FAILURE);                                                            \
+        }                                                                                       \
+    } while (false)
+
+#endif // CHECK_H_
@@ -0,0 +1,114 @@
+// Measures how long windows take to draw a frame at common sizes, and how many bytes each frame repaints.
+// Toplevels are redrawn by toggling their activation, popups by repositioning them in place.
+
+#include "benchmark.h"
+#include "check.h"
+#include "globals.h"
+#include "stats.h"
+#include "test_client.h"
+#include "test_compositor.h"
+#include "xdg-shell.h"
+
+#include <string>
+#include <vector>
+
+namespace mfa = mir_flutter_app;
+using mfa::Stats;
+using mfa::test::TestClient;
+using mfa::test::TestCompositor;
+
+namespace
+{
+MirWindowSize const sizes[]{{320, 240}, {640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+
+auto name(MirWindowArchetype archetype) -> std::string
+{
+    switch (archetype)
+    {
+    case MirWindowArchetype::regular: return "regular";
+    case MirWindowArchetype::floating_regular: return "floating_regular";
+    case MirWindowArchetype::dialog: return "dialog";
+    case MirWindowArchetype::satellite: return "satellite";
+    case MirWindowArchetype::popup: return "popup";
+    case MirWindowArchetype::tip: return "tip";
+    }
+    return {};
+}
+
+auto buffer_commits(TestCompositor const& compositor, uint32_t surface_id) -> int
+{
+    auto const surface{compositor.surface(surface_id)};
+    return surface ? surface->buffer_commits : 0;
+}
+
+// Draws frames of a window of the given size. Popups and tips get a regular window of the same size as parent.
+void draw_frames(
+    TestCompositor& compositor,
+    TestClient& client,
+    MirWindowArchetype archetype,
+    MirWindowSize size,
+    int frames)
+{
+    auto const is_popup{archetype == MirWindowArchetype::popup || archetype == MirWindowArchetype::tip};
+    auto* const parent{is_popup ? client.create_window(MirWindowArchetype::regular, size) : nullptr};
+    auto* const window{client.create_window(archetype, size, parent)};
+    auto const id{TestClient::surface_id(window)};
+    CHECK(client.dispatch_until([&] { return buffer_commits(compositor, id) > 0; }));
+
+    auto& stats{Stats::instance()};
+    auto const draws_before{stats.values(Stats::Histogram::draw_time)};
+    auto const bytes_before{stats.value(Stats::Counter::bytes_drawn)};
+    auto const allocations_before{stats.value(Stats::Counter::buffer_allocations)};
+
+    mfa::test::Stopwatch const stopwatch;
+    for (int i{0}; i < frames; ++i)
+    {
+        auto const commits{buffer_commits(compositor, id)};
+        if (is_popup)
+        {
+            mfa::Globals::instance().reposition_window(window);
+        }
+        else
+        {
+            std::vector<uint32_t> states;
+            if (i % 2 == 0) states.push_back(XDG_TOPLEVEL_STATE_ACTIVATED);
+            compositor.configure_toplevel(id, size.width, size.height, states);
+        }
+        CHECK(client.dispatch_until([&] { return buffer_commits(compositor, id) > commits; }));
+    }
+    auto const elapsed_ns{stopwatch.elapsed_ns()};
+
+    auto const draws{stats.values(Stats::Histogram::draw_time)};
+    auto const draw_count{draws.count - draws_before.count};
+    CHECK(draw_count > 0);
+
+    mfa::test::report(
+        name(archetype) + " " + std::to_string(size.width) + "x" + std::to_string(size.height),
+        {{"ns/frame", elapsed_ns / frames},
+         {"draw ns/frame", (draws.sum_us - draws_before.sum_us) * 1000.0 / draw_count},
+         {"bytes/frame", static_cast<double>(stats.value(Stats::Counter::bytes_drawn) - bytes_before) / draw_count},
+         {"allocations/frame",
+          static_cast<double>(stats.value(Stats::Counter::buffer_allocations) - allocations_before) / frames}});
+
+    // Popups are closed along with their parent, and pooled
+    auto* const toplevel{parent ? parent : window};
+    auto const toplevel_id{TestClient::surface_id(toplevel)};
+    client.close_window(toplevel);
+    CHECK(client.dispatch_until([&] { return !compositor.surface(toplevel_id); }));
+}
+}
+
+int main(int argc, char** argv)
+{
+    TestCompositor compositor;
+    TestClient client{compositor};
+
+    auto const frames{mfa::test::iterations(argc, argv, 200)};
+    for (auto const archetype : {MirWindowArchetype::regular, MirWindowArchetype::dialog, MirWindowArchetype::popup})
+    {
+        for (auto const size : sizes)
+        {
+            draw_frames(compositor, client, archetype, size, frames);
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#include "check.h"
+#include "hit_regions.h"
+
+namespace mfa = mir_flutter_app;
+
+namespace
+{
+using mfa::HitRegion;
+
+// The layout of a 400x300 decorated window with a close button, 6 px resize borders and 16 px resize corners
+auto window_layout() -> mfa::HitRegions
+{
+    return mfa::HitRegions{{
+        {HitRegion::client, 0, 0, 400, 300},
+        {HitRegion::title_bar, 0, 0, 400, 37},
+        {HitRegion::close_button, 363.5, 0.5, 399.5, 36.5},
+        {HitRegion::resize_top, 0, 0, 400, 6},
+        {HitRegion::resize_bottom, 0, 294, 400, 300},
+        {HitRegion::resize_left, 0, 0, 6, 300},
+        {HitRegion::resize_right, 394, 0, 400, 300},
+        {HitRegion::resize_top_left, 0, 0, 16, 16},
+        {HitRegion::resize_top_right, 384, 0, 400, 16},
+        {HitRegion::resize_bottom_left, 0, 284, 16, 300},
+        {HitRegion::resize_bottom_right, 384, 284, 400, 300}}};
+}
+
+void empty_regions_hit_nothing()
+{
+    CHECK(mfa::HitRegions{}.at(0, 0) == HitRegion::none);
+    CHECK(mfa::HitRegions{{}}.at(0, 0) == HitRegion::none);
+}
+
+void later_areas_take_precedence()
+{
+    auto const regions{window_layout()};
+
+    CHECK(regions.at(200, 150) == HitRegion::client);
+    CHECK(regions.at(200, 20) == HitRegion::title_bar);
+    CHECK(regions.at(370, 20) == HitRegion::close_button);
+    CHECK(regions.at(395, 5) == HitRegion::resize_top_right);
+    CHECK(regions.at(390, 30) == HitRegion::close_button);
+    CHECK(regions.at(397, 30) == HitRegion::resize_right);
+    CHECK(regions.at(200, 2) == HitRegion::resize_top);
+    CHECK(regions.at(3, 150) == HitRegion::resize_left);
+    CHECK(regions.at(10, 290) == HitRegion::resize_bottom_left);
+}
+
+void areas_exclude_their_right_and_bottom_edges()
+{
+    auto const regions{window_layout()};
+
+    CHECK(regions.at(0, 0) == HitRegion::resize_top_left);
+    CHECK(regions.at(399.9, 299.9) == HitRegion::resize_bottom_right);
+    CHECK(regions.at(400, 150) == HitRegion::none);
+    CHECK(regions.at(200, 300) == HitRegion::none);
+    CHECK(regions.at(-0.1, 150) == HitRegion::none);
+    CHECK(regions.at(200, -0.1) == HitRegion::none);
+}
+
+void gaps_between_areas_hit_nothing()
+{
+    mfa::HitRegions const regions{{
+        {HitRegion::minimize_button, 0, 0, 10, 10},
+        {HitRegion::maximize_button, 20, 20, 30, 30}}};
+
+    CHECK(regions.at(5, 5) == HitRegion::minimize_button);
+    CHECK(regions.at(25, 25) == HitRegion::maximize_button);
+    CHECK(regions.at(15, 15) == HitRegion::none);
+    CHECK(regions.at(5, 25) == HitRegion::none);
+}
+}
+
+int main()
+{
+    empty_regions_hit_nothing();
+    later_areas_take_precedence();
+    areas_exclude_their_right_and_bottom_edges();
+    gaps_between_areas_hit_nothing();
+}
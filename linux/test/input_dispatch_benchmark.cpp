@@ -0,0 +1,108 @@
+// Measures how many input events per second the runner dispatches to its windows. The compositor sends a batch of
+// events, and only the client's dispatch of the batch is timed. Focused windows are cached, so the rate should not
+// depend on how many windows are open.
+
+#include "benchmark.h"
+#include "check.h"
+#include "globals.h"
+#include "test_client.h"
+#include "test_compositor.h"
+
+#include <linux/input-event-codes.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace mfa = mir_flutter_app;
+using mfa::test::TestClient;
+using mfa::test::TestCompositor;
+
+namespace
+{
+MirWindowSize const window_size{800, 600};
+// Few enough events that the compositor never fills the socket before the client reads it
+int const batch_size{64};
+
+auto buffer_commits(TestCompositor const& compositor, uint32_t surface_id) -> int
+{
+    auto const surface{compositor.surface(surface_id)};
+    return surface ? surface->buffer_commits : 0;
+}
+
+// Sends batches of events with send_event, which is given the index of the event, and reports the rate at which
+// the client dispatches them
+void dispatch_events(
+    TestClient& client,
+    std::string const& name,
+    int batches,
+    std::function<void(int)> const& send_event)
+{
+    double dispatch_ns{0};
+    for (int batch{0}; batch < batches; ++batch)
+    {
+        for (int i{0}; i < batch_size; ++i)
+        {
+            send_event(i);
+        }
+
+        mfa::test::Stopwatch const stopwatch;
+        client.dispatch();
+        dispatch_ns += stopwatch.elapsed_ns();
+    }
+
+    auto const events{static_cast<double>(batches) * batch_size};
+    mfa::test::report(name, {{"events/s", events * 1e9 / dispatch_ns}, {"ns/event", dispatch_ns / events}});
+}
+
+void dispatch_input(TestCompositor& compositor, TestClient& client, int open_windows, int batches)
+{
+    std::vector<MirWindow*> windows;
+    for (int i{0}; i < open_windows; ++i)
+    {
+        windows.push_back(client.create_window(MirWindowArchetype::regular, window_size));
+    }
+    for (auto* const window : windows)
+    {
+        CHECK(client.dispatch_until([&] { return buffer_commits(compositor, TestClient::surface_id(window)) > 0; }));
+    }
+
+    // Input goes to the window created last
+    auto const id{TestClient::surface_id(windows.back())};
+    auto const suffix{", " + std::to_string(open_windows) + (open_windows == 1 ? " window" : " windows")};
+
+    compositor.pointer_enter(id, 400, 300);
+    dispatch_events(client, "motion" + suffix, batches, [&](int i) { compositor.pointer_motion(200 + i, 300); });
+    CHECK(std::get<0>(mfa::Globals::instance().pointer_position()) == 200 + batch_size - 1);
+
+    // Crossing from the client area to the title bar and back changes the hovered region on every event
+    dispatch_events(
+        client,
+        "motion across regions" + suffix,
+        batches,
+        [&](int i) { compositor.pointer_motion(400, i % 2 ? 18 : 300); });
+    compositor.pointer_leave();
+
+    compositor.keyboard_enter(id);
+    dispatch_events(client, "key" + suffix, batches, [&](int i) { compositor.key(KEY_A, i % 2 == 0); });
+
+    for (auto* const window : windows)
+    {
+        auto const window_id{TestClient::surface_id(window)};
+        client.close_window(window);
+        CHECK(client.dispatch_until([&] { return !compositor.surface(window_id); }));
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    TestCompositor compositor;
+    TestClient client{compositor};
+
+    auto const batches{mfa::test::iterations(argc, argv, 500)};
+    for (auto const open_windows : {1, 32})
+    {
+        dispatch_input(compositor, client, open_windows, batches);
+    }
+}
@@ -0,0 +1,507 @@
+// Measures the window method calls of the app end to end through its method channel: each call is encoded with the
+// standard method codec and handed to the channel by a loopback FlBinaryMessenger, which stands in for the Flutter
+// engine and collects the response. Reports calls per second, heap allocations per call, and latency percentiles
+// for each method.
+//
+// By default, each round of the workload creates a window of every archetype, queries them, and closes them. With
+// --replay <file>, the calls recorded by running the app with MIR_FLUTTER_APP_RECORD_CALLS set are replayed
+// instead, in their original order but without waiting between them.
+//
+// With --surfaces gtk or --surfaces direct, regular windows are created one after the other and kept open, with
+// their surfaces made by GTK or, as with MIR_FLUTTER_APP_DIRECT_SURFACES, directly from the compositor. Reports the
+// time from each call to the window's first commit, and the resident and heap memory each window adds.
+//
+// The windows are real, so this needs a Wayland compositor that supports mir_shell_v1, as the app does. It is only
+// built along with the app, as it needs the Flutter library.
+
+#include "benchmark.h"
+#include "globals.h"
+#include "mir-shell.h"
+#include "my_application.h"
+#include "stats.h"
+
+#include <flutter_linux/flutter_linux.h>
+#include <gdk/gdkwayland.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Every heap allocation goes through these, GLib's included
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+namespace
+{
+std::atomic<uint64_t> allocations{};
+}
+
+extern "C" void* malloc(size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+namespace mfa = mir_flutter_app;
+
+namespace
+{
+gchar const* const CHANNEL{"io.mir-server/window"};
+
+FlMethodCodec* method_codec()
+{
+    static FlStandardMethodCodec* const codec{fl_standard_method_codec_new()};
+    return FL_METHOD_CODEC(codec);
+}
+}
+
+// Delivers the messages the benchmark sends to the handler the method channel sets, and keeps the result of the
+// last response. Messages the app sends are answered with an empty success response, as the Dart side does.
+G_DECLARE_FINAL_TYPE(LoopbackMessenger, loopback_messenger, LOOPBACK, MESSENGER, GObject)
+
+struct _LoopbackMessenger
+{
+    GObject parent_instance;
+
+    FlBinaryMessengerMessageHandler handler;
+    gpointer handler_data;
+    GDestroyNotify handler_data_destroy;
+
+    FlValue* result;
+};
+
+static void loopback_messenger_iface_init(FlBinaryMessengerInterface* iface);
+
+G_DEFINE_TYPE_WITH_CODE(
+    LoopbackMessenger,
+    loopback_messenger,
+    G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(fl_binary_messenger_get_type(), loopback_messenger_iface_init))
+
+G_DECLARE_FINAL_TYPE(
+    LoopbackResponseHandle,
+    loopback_response_handle,
+    LOOPBACK,
+    RESPONSE_HANDLE,
+    FlBinaryMessengerResponseHandle)
+
+struct _LoopbackResponseHandle
+{
+    FlBinaryMessengerResponseHandle parent_instance;
+};
+
+G_DEFINE_TYPE(LoopbackResponseHandle, loopback_response_handle, fl_binary_messenger_response_handle_get_type())
+
+static void loopback_response_handle_class_init(LoopbackResponseHandleClass* klass) {}
+
+static void loopback_response_handle_init(LoopbackResponseHandle* self) {}
+
+static void loopback_messenger_dispose(GObject* object)
+{
+    LoopbackMessenger* const self{LOOPBACK_MESSENGER(object)};
+    if (self->handler_data_destroy)
+    {
+        self->handler_data_destroy(self->handler_data);
+    }
+    self->handler = nullptr;
+    self->handler_data_destroy = nullptr;
+    g_clear_pointer(&self->result, fl_value_unref);
+    G_OBJECT_CLASS(loopback_messenger_parent_class)->dispose(object);
+}
+
+static void loopback_messenger_class_init(LoopbackMessengerClass* klass)
+{
+    G_OBJECT_CLASS(klass)->dispose = loopback_messenger_dispose;
+}
+
+static void loopback_messenger_init(LoopbackMessenger* self) {}
+
+static void loopback_messenger_iface_init(FlBinaryMessengerInterface* iface)
+{
+    iface->set_message_handler_on_channel =
+        [](FlBinaryMessenger* messenger,
+           gchar const* /*channel*/,
+           FlBinaryMessengerMessageHandler handler,
+           gpointer user_data,
+           GDestroyNotify destroy_notify)
+        {
+            LoopbackMessenger* const self{LOOPBACK_MESSENGER(messenger)};
+            if (self->handler_data_destroy)
+            {
+                self->handler_data_destroy(self->handler_data);
+            }
+            self->handler = handler;
+            self->handler_data = user_data;
+            self->handler_data_destroy = destroy_notify;
+        };
+
+    iface->send_response =
+        [](FlBinaryMessenger* messenger,
+           FlBinaryMessengerResponseHandle* /*response_handle*/,
+           GBytes* response,
+           GError** error) -> gboolean
+        {
+            LoopbackMessenger* const self{LOOPBACK_MESSENGER(messenger)};
+            g_clear_pointer(&self->result, fl_value_unref);
+
+            g_autoptr(FlMethodResponse) decoded{
+                FL_METHOD_CODEC_GET_CLASS(method_codec())->decode_response(method_codec(), response, error)};
+            if (!decoded) return FALSE;
+
+            // Error responses have no result
+            if (FlValue* const result{fl_method_response_get_result(decoded, nullptr)})
+            {
+                self->result = fl_value_ref(result);
+            }
+            return TRUE;
+        };
+
+    iface->send_on_channel =
+        [](FlBinaryMessenger* messenger,
+           gchar const* /*channel*/,
+           GBytes* /*message*/,
+           GCancellable* cancellable,
+           GAsyncReadyCallback callback,
+           gpointer user_data)
+        {
+            if (!callback) return;
+
+            g_autoptr(GTask) task{g_task_new(messenger, cancellable, callback, user_data)};
+            g_task_return_pointer(
+                task,
+                FL_METHOD_CODEC_GET_CLASS(method_codec())->encode_success_envelope(method_codec(), nullptr, nullptr),
+                reinterpret_cast<GDestroyNotify>(g_bytes_unref));
+        };
+
+    iface->send_on_channel_finish =
+        [](FlBinaryMessenger* /*messenger*/, GAsyncResult* result, GError** error) -> GBytes*
+        {
+            return static_cast<GBytes*>(g_task_propagate_pointer(G_TASK(result), error));
+        };
+}
+
+namespace
+{
+// What the calls to one method took
+struct MethodResults
+{
+    std::vector<double> latencies_ns;
+    uint64_t allocations{};
+};
+
+class Workload
+{
+public:
+    explicit Workload(LoopbackMessenger* messenger) : messenger{messenger} {}
+
+    // Calls the method with the given arguments, which it takes, and returns the result of the call, if any
+    auto call(std::string const& method, FlValue* args) -> FlValue*
+    {
+        g_autoptr(FlValue) owned_args{args};
+        auto* const codec{method_codec()};
+        g_autoptr(GBytes) message{
+            FL_METHOD_CODEC_GET_CLASS(codec)->encode_method_call(codec, method.c_str(), owned_args, nullptr)};
+        g_autoptr(LoopbackResponseHandle) response_handle{
+            LOOPBACK_RESPONSE_HANDLE(g_object_new(loopback_response_handle_get_type(), nullptr))};
+        g_clear_pointer(&messenger->result, fl_value_unref);
+
+        auto& results{results_by_method[method]};
+        auto const allocations_before{allocations.load(std::memory_order_relaxed)};
+        mfa::test::Stopwatch const stopwatch;
+        messenger->handler(
+            FL_BINARY_MESSENGER(messenger),
+            CHANNEL,
+            message,
+            FL_BINARY_MESSENGER_RESPONSE_HANDLE(response_handle),
+            messenger->handler_data);
+        results.latencies_ns.push_back(stopwatch.elapsed_ns());
+        results.allocations += allocations.load(std::memory_order_relaxed) - allocations_before;
+
+        // Lets the windows be created, configured and drawn between calls, as they are while the app runs
+        while (g_main_context_iteration(nullptr, FALSE))
+        {
+        }
+
+        return messenger->result;
+    }
+
+    void report()
+    {
+        for (auto& [method, results] : results_by_method)
+        {
+            auto& latencies{results.latencies_ns};
+            auto total_ns{0.0};
+            for (auto const latency : latencies) total_ns += latency;
+            auto const calls{static_cast<double>(latencies.size())};
+
+            mfa::test::report(
+                method,
+                {{"calls", calls},
+                 {"calls/s", calls / total_ns * 1e9},
+                 {"allocations/call", static_cast<double>(results.allocations) / calls},
+                 {"p50 ns", mfa::test::percentile(latencies, 0.5)},
+                 {"p99 ns", mfa::test::percentile(latencies, 0.99)},
+                 {"p99.9 ns", mfa::test::percentile(latencies, 0.999)}});
+        }
+    }
+
+private:
+    LoopbackMessenger* const messenger;
+    std::map<std::string, MethodResults> results_by_method;
+};
+
+auto id_of(FlValue* result) -> int64_t
+{
+    return result && fl_value_get_type(result) == FL_VALUE_TYPE_INT ? fl_value_get_int(result) : -1;
+}
+
+auto list(std::initializer_list<FlValue*> values) -> FlValue*
+{
+    FlValue* const list{fl_value_new_list()};
+    for (auto* const value : values)
+    {
+        fl_value_append_take(list, value);
+    }
+    return list;
+}
+
+// Arguments of createSatelliteWindow, createPopupWindow and createTipWindow: the parent, the size, and a
+// positioner placing the window below the top-left corner of the parent
+auto child_args(int64_t parent_id, double width, double height) -> FlValue*
+{
+    return list({
+        fl_value_new_int(parent_id),
+        fl_value_new_float(width),
+        fl_value_new_float(height),
+        fl_value_new_float(0),
+        fl_value_new_float(0),
+        fl_value_new_float(100),
+        fl_value_new_float(40),
+        fl_value_new_int(MIR_POSITIONER_V1_ANCHOR_BOTTOM_LEFT),
+        fl_value_new_int(MIR_POSITIONER_V1_ANCHOR_TOP_LEFT),
+        fl_value_new_float(0),
+        fl_value_new_float(0),
+        fl_value_new_int(0)});
+}
+
+// A round of what a Dart app does: open a window, query it, and open and close a window of each other archetype
+// on top of it
+void run_round(Workload& workload)
+{
+    auto const regular{id_of(workload.call(
+        "createRegularWindow", list({fl_value_new_float(400), fl_value_new_float(300)})))};
+    workload.call("getWindowType", list({fl_value_new_int(regular)}));
+    workload.call("getWindowSize", list({fl_value_new_int(regular)}));
+
+    auto const floating{id_of(workload.call(
+        "createFloatingRegularWindow", list({fl_value_new_float(400), fl_value_new_float(300)})))};
+    auto const dialog{id_of(workload.call(
+        "createDialogWindow",
+        list({fl_value_new_float(300), fl_value_new_float(200), fl_value_new_int(regular)})))};
+    auto const satellite{id_of(workload.call("createSatelliteWindow", child_args(regular, 200, 300)))};
+    auto const popup{id_of(workload.call("createPopupWindow", child_args(regular, 200, 150)))};
+    auto const tip{id_of(workload.call("createTipWindow", child_args(regular, 120, 40)))};
+
+    for (auto const id : {floating, dialog, satellite, popup, tip})
+    {
+        workload.call("getWindowType", list({fl_value_new_int(id)}));
+        workload.call("getWindowSize", list({fl_value_new_int(id)}));
+    }
+
+    for (auto const id : {tip, popup, dialog, floating, regular})
+    {
+        workload.call("closeWindow", list({fl_value_new_int(id)}));
+    }
+}
+
+struct Memory
+{
+    double resident_bytes;
+    double heap_bytes;
+};
+
+// Memory the process uses: its resident pages, which include the buffers the compositor maps, and its heap in use
+auto memory() -> Memory
+{
+    std::ifstream statm{"/proc/self/statm"};
+    uint64_t size_pages{};
+    uint64_t resident_pages{};
+    statm >> size_pages >> resident_pages;
+    return {
+        .resident_bytes = static_cast<double>(resident_pages) * static_cast<double>(sysconf(_SC_PAGESIZE)),
+        .heap_bytes = static_cast<double>(mallinfo2().uordblks)};
+}
+
+// Creates windows one after the other, waiting for each to be drawn, and keeps them open to measure what each adds
+void measure_surfaces(Workload& workload, std::string const& surfaces, int windows)
+{
+    auto& stats{mfa::Stats::instance()};
+    std::vector<double> latencies_ns;
+    std::vector<int64_t> ids;
+
+    auto const before{memory()};
+    for (int i{0}; i < windows; ++i)
+    {
+        auto const commits{stats.values(mfa::Stats::Histogram::first_commit_time).count};
+        mfa::test::Stopwatch const stopwatch;
+        ids.push_back(id_of(workload.call(
+            "createRegularWindow", list({fl_value_new_float(400), fl_value_new_float(300)}))));
+        while (stats.values(mfa::Stats::Histogram::first_commit_time).count == commits)
+        {
+            g_main_context_iteration(nullptr, TRUE);
+        }
+        latencies_ns.push_back(stopwatch.elapsed_ns());
+    }
+    auto const after{memory()};
+
+    mfa::test::report(
+        surfaces + " surfaces",
+        {{"windows", static_cast<double>(windows)},
+         {"p50 us to first commit", mfa::test::percentile(latencies_ns, 0.5) / 1000},
+         {"p99 us to first commit", mfa::test::percentile(latencies_ns, 0.99) / 1000},
+         {"resident KiB/window", (after.resident_bytes - before.resident_bytes) / 1024 / windows},
+         {"heap KiB/window", (after.heap_bytes - before.heap_bytes) / 1024 / windows}});
+
+    for (auto const id : ids)
+    {
+        workload.call("closeWindow", list({fl_value_new_int(id)}));
+    }
+}
+
+// Replays the calls recorded in the file, which has one per line: the time it was made, the method name, and the
+// arguments encoded by the standard message codec in base64
+auto replay(Workload& workload, char const* path) -> bool
+{
+    std::ifstream file{path};
+    if (!file)
+    {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+
+    g_autoptr(FlStandardMessageCodec) codec{fl_standard_message_codec_new()};
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields{line};
+        uint64_t time_us{};
+        std::string method;
+        std::string encoded_args;
+        if (!(fields >> time_us >> method >> encoded_args))
+        {
+            std::cerr << "Malformed call: " << line << "\n";
+            return false;
+        }
+
+        gsize size{};
+        guchar* const data{g_base64_decode(encoded_args.c_str(), &size)};
+        g_autoptr(GBytes) bytes{g_bytes_new_take(data, size)};
+        g_autoptr(GError) error{nullptr};
+        FlValue* const args{fl_message_codec_decode_message(FL_MESSAGE_CODEC(codec), bytes, &error)};
+        if (!args)
+        {
+            std::cerr << "Malformed arguments: " << line << "\n";
+            return false;
+        }
+
+        workload.call(method, args);
+    }
+    return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+    std::string_view const replay_flag{"--replay"};
+    std::string_view const surfaces_flag{"--surfaces"};
+    auto const replaying{argc == 3 && argv[1] == replay_flag};
+    std::string const surfaces{argc >= 3 && argv[1] == surfaces_flag ? argv[2] : ""};
+    if (!surfaces.empty() && surfaces != "gtk" && surfaces != "direct")
+    {
+        std::cerr << "--surfaces takes gtk or direct\n";
+        return EXIT_FAILURE;
+    }
+
+    // Read once, when the first window is created
+    if (surfaces == "direct")
+    {
+        setenv("MIR_FLUTTER_APP_DIRECT_SURFACES", "1", 1);
+    }
+    else if (surfaces == "gtk")
+    {
+        unsetenv("MIR_FLUTTER_APP_DIRECT_SURFACES");
+    }
+
+    g_autoptr(MyApplication) application{my_application_new()};
+    g_autoptr(GError) error{nullptr};
+    // Registering the application initializes GTK, as windows can only be added to a registered application
+    if (!g_application_register(G_APPLICATION(application), nullptr, &error))
+    {
+        std::cerr << "Failed to register the application: " << error->message << "\n";
+        return EXIT_FAILURE;
+    }
+
+    GdkDisplay* const display{gdk_display_get_default()};
+    if (!display || !GDK_IS_WAYLAND_DISPLAY(display))
+    {
+        std::cerr << "This benchmark requires a Wayland display\n";
+        return EXIT_FAILURE;
+    }
+
+    auto& globals{mfa::Globals::instance()};
+    globals.bind_interfaces(gdk_wayland_display_get_wl_display(display));
+    auto ready{false};
+    globals.when_ready([&ready] { ready = true; });
+    while (!ready)
+    {
+        g_main_context_iteration(nullptr, TRUE);
+    }
+
+    g_autoptr(LoopbackMessenger) messenger{
+        LOOPBACK_MESSENGER(g_object_new(loopback_messenger_get_type(), nullptr))};
+    my_application_handle_window_calls(application, FL_BINARY_MESSENGER(messenger));
+
+    Workload workload{messenger};
+    if (!surfaces.empty())
+    {
+        measure_surfaces(workload, surfaces, mfa::test::iterations(argc, argv, 100));
+        return EXIT_SUCCESS;
+    }
+
+    if (replaying)
+    {
+        if (!replay(workload, argv[2])) return EXIT_FAILURE;
+    }
+    else
+    {
+        auto const rounds{mfa::test::iterations(argc, argv, 500)};
+        for (int i{0}; i < rounds; ++i)
+        {
+            run_round(workload);
+        }
+    }
+
+    workload.report();
+    return EXIT_SUCCESS;
+}
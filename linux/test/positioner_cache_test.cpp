@@ -0,0 +1,80 @@
+#include "check.h"
+#include "positioner_cache.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace mfa = mir_flutter_app;
+
+namespace
+{
+struct Positioner
+{
+    int64_t id;
+};
+
+std::vector<int64_t> destroyed;
+
+void destroy(Positioner* positioner)
+{
+    destroyed.push_back(positioner->id);
+    delete positioner;
+}
+
+auto key(int64_t id) -> mfa::PositionerKey
+{
+    return {id};
+}
+
+auto make(int64_t id)
+{
+    return [id] { return new Positioner{id}; };
+}
+
+void positioners_with_the_same_key_are_reused()
+{
+    auto& stats{mfa::Stats::instance()};
+    auto const created{stats.value(mfa::Stats::Counter::positioners_created)};
+    auto const reused{stats.value(mfa::Stats::Counter::positioners_reused)};
+    mfa::PositionerCache<Positioner> cache;
+
+    auto* const first{cache.get(key(1), make(1), destroy)};
+    auto* const second{cache.get(key(2), make(2), destroy)};
+    CHECK(first != second);
+    CHECK(cache.get(key(1), make(3), destroy) == first);
+    CHECK(first->id == 1);
+
+    CHECK(stats.value(mfa::Stats::Counter::positioners_created) == created + 2);
+    CHECK(stats.value(mfa::Stats::Counter::positioners_reused) == reused + 1);
+}
+
+void least_recently_used_positioner_is_destroyed_when_full()
+{
+    destroyed.clear();
+    mfa::PositionerCache<Positioner> cache;
+
+    // The capacity is 16
+    for (int64_t id{0}; id < 16; ++id)
+    {
+        cache.get(key(id), make(id), destroy);
+    }
+    CHECK(destroyed.empty());
+
+    // Using the oldest positioner makes the second oldest the least recently used
+    cache.get(key(0), make(0), destroy);
+    cache.get(key(16), make(16), destroy);
+    CHECK(destroyed == std::vector<int64_t>{1});
+
+    // Positioners evicted are made again when needed
+    auto* const remade{cache.get(key(1), make(100), destroy)};
+    CHECK(remade->id == 100);
+    CHECK(destroyed == (std::vector<int64_t>{1, 2}));
+}
+}
+
+int main()
+{
+    positioners_with_the_same_key_are_reused();
+    least_recently_used_positioner_is_destroyed_when_full();
+}
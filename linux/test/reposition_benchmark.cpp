@@ -0,0 +1,105 @@
+// Measures how many times per second a popup can be moved, by repositioning it in place and by closing it and
+// creating it again with the new positioner, as was done before popups could be repositioned.
+
+#include "benchmark.h"
+#include "check.h"
+#include "globals.h"
+#include "stats.h"
+#include "test_client.h"
+#include "test_compositor.h"
+
+namespace mfa = mir_flutter_app;
+using mfa::Stats;
+using mfa::test::TestClient;
+using mfa::test::TestCompositor;
+
+namespace
+{
+MirWindowSize const parent_size{800, 600};
+MirWindowSize const popup_size{200, 100};
+
+auto buffer_commits(TestCompositor const& compositor, uint32_t surface_id) -> int
+{
+    auto const surface{compositor.surface(surface_id)};
+    return surface ? surface->buffer_commits : 0;
+}
+
+// Positioner of the popup for the given move, sliding its anchor across the parent
+auto positioner(int move) -> MirWindowPositioner
+{
+    return {
+        .anchor_rect = {.x = 10 + (move % 50) * 10, .y = 40, .width = 100, .height = 20},
+        .anchor = MIR_POSITIONER_V1_ANCHOR_BOTTOM_LEFT,
+        .gravity = MIR_POSITIONER_V1_GRAVITY_BOTTOM_RIGHT};
+}
+
+void report(char const* name, double elapsed_ns, int moves, uint64_t allocations_before)
+{
+    auto const allocations{Stats::instance().value(Stats::Counter::buffer_allocations) - allocations_before};
+    mfa::test::report(
+        name,
+        {{"moves/s", moves * 1e9 / elapsed_ns},
+         {"ns/move", elapsed_ns / moves},
+         {"allocations/move", static_cast<double>(allocations) / moves}});
+}
+
+void reposition(TestCompositor& compositor, TestClient& client, MirWindow* parent, int moves)
+{
+    auto* const popup{client.create_window(MirWindowArchetype::popup, popup_size, parent, positioner(0))};
+    auto const id{TestClient::surface_id(popup)};
+    CHECK(client.dispatch_until([&] { return buffer_commits(compositor, id) > 0; }));
+
+    auto const allocations_before{Stats::instance().value(Stats::Counter::buffer_allocations)};
+    mfa::test::Stopwatch const stopwatch;
+    for (int i{1}; i <= moves; ++i)
+    {
+        // Each move is waited for, so none is coalesced with the next
+        auto const commits{buffer_commits(compositor, id)};
+        popup->positioner = positioner(i);
+        mfa::Globals::instance().reposition_window(popup);
+        CHECK(client.dispatch_until([&] { return buffer_commits(compositor, id) > commits; }));
+    }
+    report("reposition", stopwatch.elapsed_ns(), moves, allocations_before);
+
+    client.close_window(popup);
+}
+
+void recreate(TestCompositor& compositor, TestClient& client, MirWindow* parent, int moves)
+{
+    auto* popup{client.create_window(MirWindowArchetype::popup, popup_size, parent, positioner(0))};
+    CHECK(client.dispatch_until([&] { return buffer_commits(compositor, TestClient::surface_id(popup)) > 0; }));
+
+    auto const allocations_before{Stats::instance().value(Stats::Counter::buffer_allocations)};
+    mfa::test::Stopwatch const stopwatch;
+    for (int i{1}; i <= moves; ++i)
+    {
+        // The popup is taken back from the WindowPool, so only its role is recreated
+        auto const id{TestClient::surface_id(popup)};
+        auto const commits{buffer_commits(compositor, id)};
+        client.close_window(popup);
+        popup = client.create_window(MirWindowArchetype::popup, popup_size, parent, positioner(i));
+        CHECK(TestClient::surface_id(popup) == id);
+        CHECK(client.dispatch_until([&] { return buffer_commits(compositor, id) > commits; }));
+    }
+    report("recreate", stopwatch.elapsed_ns(), moves, allocations_before);
+
+    client.close_window(popup);
+}
+}
+
+int main(int argc, char** argv)
+{
+    TestCompositor compositor;
+    TestClient client{compositor};
+
+    auto* const parent{client.create_window(MirWindowArchetype::regular, parent_size)};
+    auto const parent_id{TestClient::surface_id(parent)};
+    CHECK(client.dispatch_until([&] { return buffer_commits(compositor, parent_id) > 0; }));
+
+    auto const moves{mfa::test::iterations(argc, argv, 1000)};
+    reposition(compositor, client, parent, moves);
+    recreate(compositor, client, parent, moves);
+
+    client.close_window(parent);
+    CHECK(client.dispatch_until([&] { return !compositor.surface(parent_id); }));
+}
@@ -0,0 +1,79 @@
+#include "check.h"
+#include "reposition_requests.h"
+#include "stats.h"
+
+namespace mfa = mir_flutter_app;
+
+namespace
+{
+auto const window_id{1};
+
+void requests_are_sent_when_none_is_in_flight()
+{
+    mfa::RepositionRequests requests;
+
+    auto const token{requests.request(window_id)};
+    CHECK(token != 0);
+    CHECK(requests.handle_repositioned(token, window_id) == 0);
+
+    auto const next_token{requests.request(window_id)};
+    CHECK(next_token != 0);
+    CHECK(next_token != token);
+}
+
+void requests_made_while_one_is_in_flight_are_coalesced()
+{
+    auto& stats{mfa::Stats::instance()};
+    auto const coalesced{stats.value(mfa::Stats::Counter::coalesced_repositions)};
+    mfa::RepositionRequests requests;
+
+    auto const token{requests.request(window_id)};
+    CHECK(requests.request(window_id) == 0);
+    CHECK(requests.request(window_id) == 0);
+    CHECK(stats.value(mfa::Stats::Counter::coalesced_repositions) == coalesced + 2);
+
+    // The coalesced requests are sent as one once the first is applied
+    auto const coalesced_token{requests.handle_repositioned(token, window_id)};
+    CHECK(coalesced_token != 0);
+    CHECK(coalesced_token != token);
+    CHECK(requests.handle_repositioned(coalesced_token, window_id) == 0);
+}
+
+void unknown_tokens_are_ignored()
+{
+    mfa::RepositionRequests requests;
+    CHECK(requests.handle_repositioned(1, window_id) == 0);
+
+    auto const token{requests.request(window_id)};
+    CHECK(requests.request(window_id) == 0);
+    CHECK(requests.handle_repositioned(token + 1, window_id) == 0);
+
+    // The request in flight is still the one that was sent
+    CHECK(requests.handle_repositioned(token, window_id) != 0);
+}
+
+void cancelled_requests_do_not_hold_back_the_next()
+{
+    mfa::RepositionRequests requests;
+
+    auto const token{requests.request(window_id)};
+    CHECK(requests.request(window_id) == 0);
+    requests.cancel();
+
+    auto const next_token{requests.request(window_id)};
+    CHECK(next_token != 0);
+    CHECK(next_token != token);
+
+    // A late answer to the cancelled request does not complete the new one
+    CHECK(requests.handle_repositioned(token, window_id) == 0);
+    CHECK(requests.request(window_id) == 0);
+}
+}
+
+int main()
+{
+    requests_are_sent_when_none_is_in_flight();
+    requests_made_while_one_is_in_flight_are_coalesced();
+    unknown_tokens_are_ignored();
+    cancelled_requests_do_not_hold_back_the_next();
+}
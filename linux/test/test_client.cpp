@@ -0,0 +1,164 @@
+#include "test_client.h"
+#include "test_compositor.h"
+#include "globals.h"
+#include "window_pool.h"
+#include "xdg_popup_window.h"
+#include "xdg_toplevel_window.h"
+
+#include <wayland-client.h>
+
+#include <glib.h>
+
+#include <cstdlib>
+#include <iostream>
+
+namespace mfa = mir_flutter_app;
+
+// Stands in for GTK, which destroys the widget of a MirWindow that Globals closes, along with its surface. Windows
+// close themselves from their input handlers, so they are only destroyed once back in the main loop.
+extern "C" void gtk_widget_destroy(GtkWidget* widget)
+{
+    g_idle_add(
+        [](gpointer data) -> gboolean
+        {
+            auto* const window{static_cast<MirWindow*>(data)};
+            if (window->parent)
+            {
+                window->parent->children.erase(window);
+            }
+
+            std::visit([](auto& window) { window.reset(); }, window->window);
+            window->base_window = nullptr;
+            wl_surface_destroy(window->surface);
+            delete window;
+            return G_SOURCE_REMOVE;
+        },
+        widget);
+}
+
+// Windows have no application to leave when they are pooled
+extern "C" void gtk_window_set_application(GtkWindow*, GtkApplication*)
+{
+}
+
+mfa::test::TestClient::TestClient(TestCompositor& compositor) :
+    display{wl_display_connect(compositor.socket_name().c_str())}
+{
+    if (!display)
+    {
+        std::cerr << "Failed to connect to the test compositor\n";
+        std::abort();
+    }
+
+    auto ready{false};
+    Globals::instance().bind_interfaces(display);
+    WindowPool::instance().set_release_handler([](MirWindow* window)
+        {
+            if (window->parent)
+            {
+                window->parent->children.erase(window);
+                window->parent = nullptr;
+            }
+        });
+    Globals::instance().when_ready([&ready] { ready = true; });
+    if (!dispatch_until([&ready] { return ready; }))
+    {
+        std::cerr << "Timed out binding the test compositor's globals\n";
+        std::abort();
+    }
+}
+
+auto mfa::test::TestClient::dispatch_until(std::function<bool()> const& done, std::chrono::milliseconds timeout)
+    -> bool
+{
+    auto const deadline{std::chrono::steady_clock::now() + timeout};
+    while (!done())
+    {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        dispatch();
+    }
+    return true;
+}
+
+void mfa::test::TestClient::dispatch()
+{
+    // GDK is not there to read the socket, so the round trip does, and then dispatches the runner's queue. The main
+    // loop presents the frames drawn on the render thread.
+    wl_display_roundtrip_queue(display, Globals::instance().event_queue());
+    while (g_main_context_iteration(nullptr, FALSE))
+    {
+    }
+}
+
+auto mfa::test::TestClient::create_window(
+    MirWindowArchetype archetype,
+    MirWindowSize size,
+    MirWindow* parent,
+    MirWindowPositioner positioner) -> MirWindow*
+{
+    auto& globals{Globals::instance()};
+
+    auto* const pooled{archetype != MirWindowArchetype::satellite ?
+        WindowPool::instance().acquire(archetype, size) :
+        nullptr};
+    auto* const window{pooled ? pooled : new _MirWindow{}};
+    window->id = next_window_id++;
+    window->created = std::chrono::steady_clock::now();
+    window->archetype = archetype;
+    window->size = size;
+    window->positioner = positioner;
+    window->parent = parent;
+    if (parent)
+    {
+        parent->children.insert(window);
+    }
+
+    if (pooled)
+    {
+        globals.reuse_popup_window(window);
+        wl_display_flush(display);
+        return window;
+    }
+
+    // As with MIR_FLUTTER_APP_DIRECT_SURFACES, the surface is not GTK's
+    window->surface = wl_compositor_create_surface(globals.compositor());
+    window->owns_surface = true;
+    switch (archetype)
+    {
+    case MirWindowArchetype::regular:
+        window->window = globals.make_regular_window(window);
+        break;
+    case MirWindowArchetype::floating_regular:
+        window->window = globals.make_floating_regular_window(window);
+        break;
+    case MirWindowArchetype::dialog:
+        window->window = globals.make_dialog_window(window);
+        break;
+    case MirWindowArchetype::satellite:
+        window->window = globals.make_satellite_window(window);
+        break;
+    case MirWindowArchetype::popup:
+        window->window = globals.make_popup_window(window);
+        break;
+    case MirWindowArchetype::tip:
+        window->window = globals.make_tip_window(window);
+        break;
+    }
+    window->base_window = std::visit([](auto const& window) -> Window* { return window.get(); }, window->window);
+
+    // GDK commits the surface when the widget is mapped
+    wl_surface_commit(window->surface);
+    wl_display_flush(display);
+    return window;
+}
+
+void mfa::test::TestClient::close_window(MirWindow* window)
+{
+    Globals::instance().close_window(window->surface);
+    wl_display_flush(display);
+}
+
+auto mfa::test::TestClient::surface_id(MirWindow const* window) -> uint32_t
+{
+    return wl_proxy_get_id(reinterpret_cast<wl_proxy*>(window->surface));
+}
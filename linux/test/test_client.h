@@ -0,0 +1,55 @@
+#ifndef TEST_CLIENT_H_
+#define TEST_CLIENT_H_
+
+#include "mir_window.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+struct wl_display;
+
+namespace mir_flutter_app::test
+{
+class TestCompositor;
+
+// Connects the runner's Globals to a TestCompositor, and creates windows the way MirWindow does once it has a
+// surface. GTK is never initialized: the windows are plain _MirWindow structures, and the few GTK calls the runner
+// makes on them are replaced by ones that destroy the window and its surface. As Globals is a singleton, there can
+// only be one client per process.
+class TestClient
+{
+public:
+    // Returns once the globals are bound and a buffer backend is chosen
+    explicit TestClient(TestCompositor& compositor);
+
+    TestClient(TestClient const&) = delete;
+    TestClient& operator=(TestClient const&) = delete;
+
+    // Dispatches the runner's Wayland events and GLib sources until done returns true. Returns false on timeout.
+    auto dispatch_until(std::function<bool()> const& done, std::chrono::milliseconds timeout = std::chrono::seconds{5})
+        -> bool;
+    // Dispatches the events the compositor has sent so far
+    void dispatch();
+
+    // Creates a window and commits its surface, which asks the compositor for the first configure. Popups and tips
+    // are taken from the WindowPool when it has one of their size class.
+    auto create_window(
+        MirWindowArchetype archetype,
+        MirWindowSize size,
+        MirWindow* parent = nullptr,
+        MirWindowPositioner positioner = {}) -> MirWindow*;
+    // Closes the window and its children through Globals, as the Flutter app does. Closed popups and tips are pooled
+    // rather than destroyed.
+    void close_window(MirWindow* window);
+
+    // ID of the window's surface, which the compositor knows it by
+    static auto surface_id(MirWindow const* window) -> uint32_t;
+
+private:
+    wl_display* display;
+    int next_window_id{1};
+};
+}
+
+#endif // TEST_CLIENT_H_
@@ -0,0 +1,803 @@
+#include "test_compositor.h"
+
+#include <wayland-server.h>
+
+#include "xdg-shell-server.h"
+#include "mir-shell-server.h"
+
+#include <poll.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace mfa = mir_flutter_app;
+
+struct mfa::test::CompositorState
+{
+    struct SurfaceData
+    {
+        wl_resource* resource{};
+        wl_resource* xdg_surface{};
+        wl_resource* xdg_toplevel{};
+        wl_resource* xdg_popup{};
+        wl_resource* pending_buffer{};
+        bool buffer_attached{};
+        bool configured{};
+        int32_t popup_width{};
+        int32_t popup_height{};
+        std::vector<wl_resource*> pending_frames;
+        TestCompositor::Surface recorded;
+    };
+
+    wl_display* display{};
+    std::string socket_name;
+    std::chrono::steady_clock::time_point started{std::chrono::steady_clock::now()};
+
+    std::map<uint32_t, SurfaceData> surfaces;
+    wl_resource* pointer{};
+    wl_resource* keyboard{};
+    uint32_t pointer_focus{};
+    uint32_t input_serial{};
+    bool hold_frames{};
+    std::vector<wl_resource*> held_frames;
+    bool answer_repositions{true};
+
+    std::mutex mutex;
+    std::atomic<bool> stopping{};
+    std::thread thread;
+};
+
+namespace
+{
+using mfa::test::CompositorState;
+using mfa::test::TestCompositor;
+
+// What a role object, or the surface itself, refers to. Surfaces are looked up by ID, as the objects that refer to
+// them may outlive them.
+struct SurfaceRef
+{
+    CompositorState* state;
+    uint32_t surface_id;
+};
+
+struct Positioner
+{
+    int32_t width{};
+    int32_t height{};
+};
+
+auto const ignore{[](auto...) {}};
+
+void destroy_resource(wl_client*, wl_resource* resource)
+{
+    wl_resource_destroy(resource);
+}
+
+auto state_of(wl_resource* resource) -> CompositorState&
+{
+    return *static_cast<SurfaceRef*>(wl_resource_get_user_data(resource))->state;
+}
+
+auto surface_of(wl_resource* resource) -> CompositorState::SurfaceData*
+{
+    auto const* const ref{static_cast<SurfaceRef*>(wl_resource_get_user_data(resource))};
+    auto const surface{ref->state->surfaces.find(ref->surface_id)};
+    return surface != ref->state->surfaces.end() ? &surface->second : nullptr;
+}
+
+void delete_surface_ref(wl_resource* resource)
+{
+    delete static_cast<SurfaceRef*>(wl_resource_get_user_data(resource));
+}
+
+auto now_ms(CompositorState const& state) -> uint32_t
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - state.started).count());
+}
+
+void send_configure(CompositorState& state, CompositorState::SurfaceData& surface)
+{
+    surface.recorded.configure_serial = wl_display_next_serial(state.display);
+    xdg_surface_send_configure(surface.xdg_surface, surface.recorded.configure_serial);
+}
+
+void send_toplevel_configure(
+    CompositorState& state,
+    CompositorState::SurfaceData& surface,
+    int32_t width,
+    int32_t height,
+    std::vector<uint32_t> const& states)
+{
+    wl_array array;
+    wl_array_init(&array);
+    for (auto const value : states)
+    {
+        *static_cast<uint32_t*>(wl_array_add(&array, sizeof(uint32_t))) = value;
+    }
+    xdg_toplevel_send_configure(surface.xdg_toplevel, width, height, &array);
+    wl_array_release(&array);
+
+    send_configure(state, surface);
+}
+
+void send_popup_configure(CompositorState& state, CompositorState::SurfaceData& surface)
+{
+    xdg_popup_send_configure(surface.xdg_popup, 0, 0, surface.popup_width, surface.popup_height);
+    send_configure(state, surface);
+}
+
+void send_frame_done(CompositorState& state, std::vector<wl_resource*> callbacks)
+{
+    for (auto* const callback : callbacks)
+    {
+        wl_callback_send_done(callback, now_ms(state));
+        wl_resource_destroy(callback);
+    }
+}
+
+// Callbacks are only destroyed by the compositor, or with the client
+void forget_frame_callback(wl_resource* callback)
+{
+    auto& state{*static_cast<CompositorState*>(wl_resource_get_user_data(callback))};
+    std::erase(state.held_frames, callback);
+    for (auto& [_, surface] : state.surfaces)
+    {
+        std::erase(surface.pending_frames, callback);
+    }
+}
+
+void commit(CompositorState& state, CompositorState::SurfaceData& surface)
+{
+    auto& recorded{surface.recorded};
+    ++recorded.commits;
+
+    if (std::exchange(surface.buffer_attached, false))
+    {
+        if (auto* const buffer{std::exchange(surface.pending_buffer, nullptr)})
+        {
+            if (auto* const shm_buffer{wl_shm_buffer_get(buffer)})
+            {
+                recorded.buffer_width = wl_shm_buffer_get_width(shm_buffer);
+                recorded.buffer_height = wl_shm_buffer_get_height(shm_buffer);
+                recorded.buffer_format = wl_shm_buffer_get_format(shm_buffer);
+            }
+            ++recorded.buffer_commits;
+
+            // Nothing is composited, so the buffer is not needed past the commit
+            wl_buffer_send_release(buffer);
+        }
+        else
+        {
+            // An unmapped surface is configured again on its next commit
+            recorded.buffer_width = 0;
+            recorded.buffer_height = 0;
+            surface.configured = false;
+        }
+    }
+
+    auto frames{std::exchange(surface.pending_frames, {})};
+    if (state.hold_frames)
+    {
+        state.held_frames.insert(state.held_frames.end(), frames.begin(), frames.end());
+    }
+    else
+    {
+        send_frame_done(state, std::move(frames));
+    }
+
+    // The first commit of a surface with a role asks for its first configure
+    if (!surface.configured && (surface.xdg_toplevel || surface.xdg_popup))
+    {
+        surface.configured = true;
+        if (surface.xdg_toplevel)
+        {
+            send_toplevel_configure(state, surface, 0, 0, {});
+        }
+        else
+        {
+            send_popup_configure(state, surface);
+        }
+    }
+}
+
+struct wl_region_interface const region_impl{
+    .destroy = destroy_resource,
+    .add = ignore,
+    .subtract = ignore};
+
+struct wl_surface_interface const surface_impl{
+    .destroy = destroy_resource,
+    .attach = [](wl_client*, wl_resource* resource, wl_resource* buffer, int32_t, int32_t)
+        {
+            if (auto* const surface{surface_of(resource)})
+            {
+                surface->pending_buffer = buffer;
+                surface->buffer_attached = true;
+            }
+        },
+    .damage = ignore,
+    .frame = [](wl_client* client, wl_resource* resource, uint32_t id)
+        {
+            auto* const callback{wl_resource_create(client, &wl_callback_interface, 1, id)};
+            wl_resource_set_implementation(callback, nullptr, &state_of(resource), forget_frame_callback);
+            if (auto* const surface{surface_of(resource)})
+            {
+                surface->pending_frames.push_back(callback);
+            }
+        },
+    .set_opaque_region = ignore,
+    .set_input_region = ignore,
+    .commit = [](wl_client*, wl_resource* resource)
+        {
+            if (auto* const surface{surface_of(resource)})
+            {
+                commit(state_of(resource), *surface);
+            }
+        },
+    .set_buffer_transform = ignore,
+    .set_buffer_scale = ignore,
+    .damage_buffer = ignore,
+    .offset = ignore};
+
+struct wl_compositor_interface const compositor_impl{
+    .create_surface = [](wl_client* client, wl_resource* resource, uint32_t id)
+        {
+            auto& state{*static_cast<CompositorState*>(wl_resource_get_user_data(resource))};
+            auto* const surface{
+                wl_resource_create(client, &wl_surface_interface, wl_resource_get_version(resource), id)};
+            wl_resource_set_implementation(
+                surface,
+                &surface_impl,
+                new SurfaceRef{&state, id},
+                [](wl_resource* surface)
+                {
+                    auto* const ref{static_cast<SurfaceRef*>(wl_resource_get_user_data(surface))};
+                    ref->state->surfaces.erase(ref->surface_id);
+                    delete ref;
+                });
+            state.surfaces[id] = {.resource = surface};
+        },
+    .create_region = [](wl_client* client, wl_resource* resource, uint32_t id)
+        {
+            auto* const region{wl_resource_create(client, &wl_region_interface, wl_resource_get_version(resource), id)};
+            wl_resource_set_implementation(region, &region_impl, nullptr, nullptr);
+        }};
+
+struct wl_subsurface_interface const subsurface_impl{
+    .destroy = destroy_resource,
+    .set_position = ignore,
+    .place_above = ignore,
+    .place_below = ignore,
+    .set_sync = ignore,
+    .set_desync = ignore};
+
+struct wl_subcompositor_interface const subcompositor_impl{
+    .destroy = destroy_resource,
+    .get_subsurface = [](wl_client* client, wl_resource* resource, uint32_t id, wl_resource* surface, wl_resource*)
+        {
+            auto* const subsurface{wl_resource_create(client, &wl_subsurface_interface, 1, id)};
+            wl_resource_set_implementation(subsurface, &subsurface_impl, nullptr, nullptr);
+            if (auto* const data{surface_of(surface)})
+            {
+                data->recorded.role = TestCompositor::Role::subsurface;
+            }
+        }};
+
+struct wl_pointer_interface const pointer_impl{
+    .set_cursor = ignore,
+    .release = destroy_resource};
+
+struct wl_keyboard_interface const keyboard_impl{
+    .release = destroy_resource};
+
+struct wl_seat_interface const seat_impl{
+    .get_pointer = [](wl_client* client, wl_resource* resource, uint32_t id)
+        {
+            auto& state{*static_cast<CompositorState*>(wl_resource_get_user_data(resource))};
+            state.pointer = wl_resource_create(client, &wl_pointer_interface, wl_resource_get_version(resource), id);
+            wl_resource_set_implementation(state.pointer, &pointer_impl, &state, [](wl_resource* pointer)
+                {
+                    static_cast<CompositorState*>(wl_resource_get_user_data(pointer))->pointer = nullptr;
+                });
+        },
+    .get_keyboard = [](wl_client* client, wl_resource* resource, uint32_t id)
+        {
+            auto& state{*static_cast<CompositorState*>(wl_resource_get_user_data(resource))};
+            state.keyboard = wl_resource_create(client, &wl_keyboard_interface, wl_resource_get_version(resource), id);
+            wl_resource_set_implementation(state.keyboard, &keyboard_impl, &state, [](wl_resource* keyboard)
+                {
+                    static_cast<CompositorState*>(wl_resource_get_user_data(keyboard))->keyboard = nullptr;
+                });
+        },
+    .get_touch = ignore,
+    .release = destroy_resource};
+
+struct wl_output_interface const output_impl{
+    .release = destroy_resource};
+
+struct xdg_positioner_interface const positioner_impl{
+    .destroy = destroy_resource,
+    .set_size = [](wl_client*, wl_resource* resource, int32_t width, int32_t height)
+        {
+            *static_cast<Positioner*>(wl_resource_get_user_data(resource)) = {width, height};
+        },
+    .set_anchor_rect = ignore,
+    .set_anchor = ignore,
+    .set_gravity = ignore,
+    .set_constraint_adjustment = ignore,
+    .set_offset = ignore,
+    .set_reactive = ignore,
+    .set_parent_size = ignore,
+    .set_parent_configure = ignore};
+
+struct xdg_toplevel_interface const toplevel_impl{
+    .destroy = destroy_resource,
+    .set_parent = ignore,
+    .set_title = ignore,
+    .set_app_id = ignore,
+    .show_window_menu = ignore,
+    .move = [](wl_client*, wl_resource* resource, wl_resource*, uint32_t serial)
+        {
+            if (auto* const surface{surface_of(resource)})
+            {
+                ++surface->recorded.moves;
+                surface->recorded.grab_serial = serial;
+            }
+        },
+    .resize = [](wl_client*, wl_resource* resource, wl_resource*, uint32_t serial, uint32_t)
+        {
+            if (auto* const surface{surface_of(resource)})
+            {
+                ++surface->recorded.resizes;
+                surface->recorded.grab_serial = serial;
+            }
+        },
+    .set_max_size = ignore,
+    .set_min_size = ignore,
+    .set_maximized = ignore,
+    .unset_maximized = ignore,
+    .set_fullscreen = ignore,
+    .unset_fullscreen = ignore,
+    .set_minimized = ignore};
+
+struct xdg_popup_interface const popup_impl{
+    .destroy = destroy_resource,
+    .grab = ignore,
+    .reposition = [](wl_client*, wl_resource* resource, wl_resource* positioner, uint32_t token)
+        {
+            auto* const surface{surface_of(resource)};
+            if (!surface) return;
+
+            ++surface->recorded.repositions;
+            if (!state_of(resource).answer_repositions) return;
+
+            auto const* const placement{static_cast<Positioner*>(wl_resource_get_user_data(positioner))};
+            surface->popup_width = placement->width;
+            surface->popup_height = placement->height;
+            xdg_popup_send_repositioned(resource, token);
+            send_popup_configure(state_of(resource), *surface);
+        }};
+
+// Clears the surface's reference to a role object when the object is destroyed
+template<wl_resource* CompositorState::SurfaceData::*member>
+void forget_role(wl_resource* resource)
+{
+    if (auto* const surface{surface_of(resource)})
+    {
+        surface->*member = nullptr;
+        surface->configured = false;
+        if (!surface->xdg_toplevel && !surface->xdg_popup && surface->recorded.role != TestCompositor::Role::subsurface)
+        {
+            surface->recorded.role = TestCompositor::Role::none;
+        }
+    }
+    delete_surface_ref(resource);
+}
+
+struct xdg_surface_interface const xdg_surface_impl{
+    .destroy = destroy_resource,
+    .get_toplevel = [](wl_client* client, wl_resource* resource, uint32_t id)
+        {
+            auto* const toplevel{
+                wl_resource_create(client, &xdg_toplevel_interface, wl_resource_get_version(resource), id)};
+            wl_resource_set_implementation(
+                toplevel,
+                &toplevel_impl,
+                new SurfaceRef{*static_cast<SurfaceRef*>(wl_resource_get_user_data(resource))},
+                forget_role<&CompositorState::SurfaceData::xdg_toplevel>);
+            if (auto* const surface{surface_of(resource)})
+            {
+                surface->xdg_toplevel = toplevel;
+                surface->recorded.role = TestCompositor::Role::toplevel;
+            }
+        },
+    .get_popup = [](wl_client* client, wl_resource* resource, uint32_t id, wl_resource*, wl_resource* positioner)
+        {
+            auto* const popup{wl_resource_create(client, &xdg_popup_interface, wl_resource_get_version(resource), id)};
+            wl_resource_set_implementation(
+                popup,
+                &popup_impl,
+                new SurfaceRef{*static_cast<SurfaceRef*>(wl_resource_get_user_data(resource))},
+                forget_role<&CompositorState::SurfaceData::xdg_popup>);
+            if (auto* const surface{surface_of(resource)})
+            {
+                auto const* const placement{static_cast<Positioner*>(wl_resource_get_user_data(positioner))};
+                surface->xdg_popup = popup;
+                surface->popup_width = placement->width;
+                surface->popup_height = placement->height;
+                surface->recorded.role = TestCompositor::Role::popup;
+            }
+        },
+    .set_window_geometry = ignore,
+    .ack_configure = [](wl_client*, wl_resource* resource, uint32_t serial)
+        {
+            if (auto* const surface{surface_of(resource)})
+            {
+                surface->recorded.acked_serial = serial;
+            }
+        }};
+
+struct xdg_wm_base_interface const wm_base_impl{
+    .destroy = destroy_resource,
+    .create_positioner = [](wl_client* client, wl_resource* resource, uint32_t id)
+        {
+            auto* const positioner{
+                wl_resource_create(client, &xdg_positioner_interface, wl_resource_get_version(resource), id)};
+            wl_resource_set_implementation(positioner, &positioner_impl, new Positioner{}, [](wl_resource* positioner)
+                {
+                    delete static_cast<Positioner*>(wl_resource_get_user_data(positioner));
+                });
+        },
+    .get_xdg_surface = [](wl_client* client, wl_resource* resource, uint32_t id, wl_resource* surface)
+        {
+            auto* const xdg_surface{
+                wl_resource_create(client, &xdg_surface_interface, wl_resource_get_version(resource), id)};
+            wl_resource_set_implementation(
+                xdg_surface,
+                &xdg_surface_impl,
+                new SurfaceRef{*static_cast<SurfaceRef*>(wl_resource_get_user_data(surface))},
+                forget_role<&CompositorState::SurfaceData::xdg_surface>);
+            if (auto* const data{surface_of(surface)})
+            {
+                data->xdg_surface = xdg_surface;
+            }
+        },
+    .pong = ignore};
+
+struct mir_positioner_v1_interface const mir_positioner_impl{
+    .destroy = destroy_resource,
+    .set_size = ignore,
+    .set_anchor_rect = ignore,
+    .set_anchor = ignore,
+    .set_gravity = ignore,
+    .set_constraint_adjustment = ignore,
+    .set_offset = ignore};
+
+struct mir_regular_surface_v1_interface const mir_regular_surface_impl{.destroy = destroy_resource};
+struct mir_floating_regular_surface_v1_interface const mir_floating_regular_surface_impl{.destroy = destroy_resource};
+struct mir_dialog_surface_v1_interface const mir_dialog_surface_impl{.destroy = destroy_resource};
+
+struct mir_satellite_surface_v1_interface const mir_satellite_surface_impl{
+    .reposition = [](wl_client*, wl_resource* resource, wl_resource*, uint32_t token)
+        {
+            auto* const surface{surface_of(resource)};
+            if (!surface) return;
+
+            ++surface->recorded.repositions;
+            if (!state_of(resource).answer_repositions || !surface->xdg_toplevel) return;
+
+            mir_satellite_surface_v1_send_repositioned(resource, token);
+            send_toplevel_configure(state_of(resource), *surface, 0, 0, {});
+        },
+    .destroy = destroy_resource};
+
+// Gives the surface an archetype through a mir_shell_v1 role object
+void create_archetype(
+    wl_client* client,
+    wl_resource* surface,
+    uint32_t id,
+    wl_interface const* interface,
+    void const* implementation,
+    char const* archetype)
+{
+    auto* const role{wl_resource_create(client, interface, 1, id)};
+    wl_resource_set_implementation(
+        role,
+        implementation,
+        new SurfaceRef{*static_cast<SurfaceRef*>(wl_resource_get_user_data(surface))},
+        delete_surface_ref);
+    if (auto* const data{surface_of(surface)})
+    {
+        data->recorded.archetype = archetype;
+    }
+}
+
+struct mir_shell_v1_interface const mir_shell_impl{
+    .get_regular_surface = [](wl_client* client, wl_resource*, uint32_t id, wl_resource* surface)
+        {
+            create_archetype(
+                client, surface, id, &mir_regular_surface_v1_interface, &mir_regular_surface_impl, "regular");
+        },
+    .get_floating_regular_surface = [](wl_client* client, wl_resource*, uint32_t id, wl_resource* surface)
+        {
+            create_archetype(
+                client,
+                surface,
+                id,
+                &mir_floating_regular_surface_v1_interface,
+                &mir_floating_regular_surface_impl,
+                "floating_regular");
+        },
+    .get_dialog_surface = [](wl_client* client, wl_resource*, uint32_t id, wl_resource* surface)
+        {
+            create_archetype(client, surface, id, &mir_dialog_surface_v1_interface, &mir_dialog_surface_impl, "dialog");
+        },
+    .get_satellite_surface = [](wl_client* client, wl_resource*, uint32_t id, wl_resource* surface, wl_resource*)
+        {
+            create_archetype(
+                client, surface, id, &mir_satellite_surface_v1_interface, &mir_satellite_surface_impl, "satellite");
+        },
+    .create_positioner = [](wl_client* client, wl_resource*, uint32_t id)
+        {
+            auto* const positioner{wl_resource_create(client, &mir_positioner_v1_interface, 1, id)};
+            wl_resource_set_implementation(positioner, &mir_positioner_impl, nullptr, nullptr);
+        },
+    .destroy = destroy_resource};
+
+// Binds a resource of the global's interface with the given implementation and the compositor state as user data
+template<wl_interface const* interface, auto const* implementation>
+void bind(wl_client* client, void* data, uint32_t version, uint32_t id)
+{
+    auto* const resource{wl_resource_create(client, interface, static_cast<int>(version), id)};
+    wl_resource_set_implementation(resource, implementation, data, nullptr);
+}
+
+void bind_seat(wl_client* client, void* data, uint32_t version, uint32_t id)
+{
+    auto* const resource{wl_resource_create(client, &wl_seat_interface, static_cast<int>(version), id)};
+    wl_resource_set_implementation(resource, &seat_impl, data, nullptr);
+    wl_seat_send_capabilities(resource, WL_SEAT_CAPABILITY_POINTER | WL_SEAT_CAPABILITY_KEYBOARD);
+    if (version >= WL_SEAT_NAME_SINCE_VERSION) wl_seat_send_name(resource, "seat0");
+}
+
+void bind_output(wl_client* client, void* data, uint32_t version, uint32_t id)
+{
+    auto* const resource{wl_resource_create(client, &wl_output_interface, static_cast<int>(version), id)};
+    wl_resource_set_implementation(resource, &output_impl, data, nullptr);
+    wl_output_send_geometry(resource, 0, 0, 600, 340, 0, "mir_flutter_app", "test", 0);
+    wl_output_send_mode(resource, WL_OUTPUT_MODE_CURRENT | WL_OUTPUT_MODE_PREFERRED, 1920, 1080, 60000);
+    if (version >= WL_OUTPUT_SCALE_SINCE_VERSION) wl_output_send_scale(resource, 1);
+    if (version >= WL_OUTPUT_DONE_SINCE_VERSION) wl_output_send_done(resource);
+}
+
+void send_pointer_frame(wl_resource* pointer)
+{
+    if (wl_resource_get_version(pointer) >= WL_POINTER_FRAME_SINCE_VERSION) wl_pointer_send_frame(pointer);
+}
+}
+
+mfa::test::TestCompositor::TestCompositor() :
+    state{std::make_unique<CompositorState>()}
+{
+    // The socket is created in XDG_RUNTIME_DIR, which is not always set where tests run
+    if (!std::getenv("XDG_RUNTIME_DIR"))
+    {
+        static char runtime_dir[]{"/tmp/mir_flutter_app-test-XXXXXX"};
+        if (mkdtemp(runtime_dir)) setenv("XDG_RUNTIME_DIR", runtime_dir, 0);
+    }
+
+    state->display = wl_display_create();
+    auto const* const socket{wl_display_add_socket_auto(state->display)};
+    if (!socket)
+    {
+        std::cerr << "Failed to create a Wayland socket for the test compositor\n";
+        std::abort();
+    }
+    state->socket_name = socket;
+
+    wl_display_init_shm(state->display);
+    wl_global_create(state->display, &wl_compositor_interface, 4, state.get(),
+        bind<&wl_compositor_interface, &compositor_impl>);
+    wl_global_create(state->display, &wl_subcompositor_interface, 1, state.get(),
+        bind<&wl_subcompositor_interface, &subcompositor_impl>);
+    wl_global_create(state->display, &wl_seat_interface, 5, state.get(), bind_seat);
+    wl_global_create(state->display, &wl_output_interface, 3, state.get(), bind_output);
+    wl_global_create(state->display, &xdg_wm_base_interface, 6, state.get(),
+        bind<&xdg_wm_base_interface, &wm_base_impl>);
+    wl_global_create(state->display, &mir_shell_v1_interface, 1, state.get(),
+        bind<&mir_shell_v1_interface, &mir_shell_impl>);
+
+    state->thread = std::thread{[state = state.get()]
+        {
+            auto* const loop{wl_display_get_event_loop(state->display)};
+            pollfd fd{.fd = wl_event_loop_get_fd(loop), .events = POLLIN, .revents = 0};
+            while (!state->stopping)
+            {
+                poll(&fd, 1, 10);
+
+                std::lock_guard const lock{state->mutex};
+                wl_event_loop_dispatch(loop, 0);
+                wl_display_flush_clients(state->display);
+            }
+        }};
+}
+
+mfa::test::TestCompositor::~TestCompositor()
+{
+    state->stopping = true;
+    state->thread.join();
+
+    wl_display_destroy_clients(state->display);
+    wl_display_destroy(state->display);
+}
+
+auto mfa::test::TestCompositor::socket_name() const -> std::string const&
+{
+    return state->socket_name;
+}
+
+auto mfa::test::TestCompositor::surface(uint32_t id) const -> std::optional<Surface>
+{
+    std::optional<Surface> result;
+    run([&](CompositorState& state)
+        {
+            if (auto const surface{state.surfaces.find(id)}; surface != state.surfaces.end())
+            {
+                result = surface->second.recorded;
+            }
+        });
+    return result;
+}
+
+void mfa::test::TestCompositor::configure_toplevel(
+    uint32_t surface_id,
+    int32_t width,
+    int32_t height,
+    std::vector<uint32_t> states)
+{
+    run([&](CompositorState& state)
+        {
+            auto const surface{state.surfaces.find(surface_id)};
+            if (surface == state.surfaces.end() || !surface->second.xdg_toplevel) return;
+
+            send_toplevel_configure(state, surface->second, width, height, states);
+        });
+}
+
+void mfa::test::TestCompositor::popup_done(uint32_t surface_id)
+{
+    run([&](CompositorState& state)
+        {
+            auto const surface{state.surfaces.find(surface_id)};
+            if (surface == state.surfaces.end() || !surface->second.xdg_popup) return;
+
+            xdg_popup_send_popup_done(surface->second.xdg_popup);
+        });
+}
+
+void mfa::test::TestCompositor::pointer_enter(uint32_t surface_id, double x, double y)
+{
+    run([&](CompositorState& state)
+        {
+            auto const surface{state.surfaces.find(surface_id)};
+            if (!state.pointer || surface == state.surfaces.end()) return;
+
+            state.pointer_focus = surface_id;
+            state.input_serial = wl_display_next_serial(state.display);
+            wl_pointer_send_enter(
+                state.pointer,
+                state.input_serial,
+                surface->second.resource,
+                wl_fixed_from_double(x),
+                wl_fixed_from_double(y));
+            send_pointer_frame(state.pointer);
+        });
+}
+
+void mfa::test::TestCompositor::pointer_leave()
+{
+    run([&](CompositorState& state)
+        {
+            auto const surface{state.surfaces.find(std::exchange(state.pointer_focus, 0))};
+            if (!state.pointer || surface == state.surfaces.end()) return;
+
+            state.input_serial = wl_display_next_serial(state.display);
+            wl_pointer_send_leave(state.pointer, state.input_serial, surface->second.resource);
+            send_pointer_frame(state.pointer);
+        });
+}
+
+void mfa::test::TestCompositor::pointer_motion(double x, double y)
+{
+    run([&](CompositorState& state)
+        {
+            if (!state.pointer) return;
+
+            wl_pointer_send_motion(state.pointer, now_ms(state), wl_fixed_from_double(x), wl_fixed_from_double(y));
+            send_pointer_frame(state.pointer);
+        });
+}
+
+void mfa::test::TestCompositor::pointer_button(uint32_t button, bool pressed)
+{
+    run([&](CompositorState& state)
+        {
+            if (!state.pointer) return;
+
+            state.input_serial = wl_display_next_serial(state.display);
+            wl_pointer_send_button(
+                state.pointer,
+                state.input_serial,
+                now_ms(state),
+                button,
+                pressed ? WL_POINTER_BUTTON_STATE_PRESSED : WL_POINTER_BUTTON_STATE_RELEASED);
+            send_pointer_frame(state.pointer);
+        });
+}
+
+void mfa::test::TestCompositor::keyboard_enter(uint32_t surface_id)
+{
+    run([&](CompositorState& state)
+        {
+            auto const surface{state.surfaces.find(surface_id)};
+            if (!state.keyboard || surface == state.surfaces.end()) return;
+
+            wl_array keys;
+            wl_array_init(&keys);
+            state.input_serial = wl_display_next_serial(state.display);
+            wl_keyboard_send_enter(state.keyboard, state.input_serial, surface->second.resource, &keys);
+            wl_array_release(&keys);
+        });
+}
+
+void mfa::test::TestCompositor::key(uint32_t key, bool pressed)
+{
+    run([&](CompositorState& state)
+        {
+            if (!state.keyboard) return;
+
+            state.input_serial = wl_display_next_serial(state.display);
+            wl_keyboard_send_key(
+                state.keyboard,
+                state.input_serial,
+                now_ms(state),
+                key,
+                pressed ? WL_KEYBOARD_KEY_STATE_PRESSED : WL_KEYBOARD_KEY_STATE_RELEASED);
+        });
+}
+
+auto mfa::test::TestCompositor::input_serial() const -> uint32_t
+{
+    uint32_t serial{};
+    run([&](CompositorState& state) { serial = state.input_serial; });
+    return serial;
+}
+
+void mfa::test::TestCompositor::hold_frame_callbacks(bool hold)
+{
+    run([&](CompositorState& state) { state.hold_frames = hold; });
+}
+
+void mfa::test::TestCompositor::release_frame_callbacks()
+{
+    run([](CompositorState& state) { send_frame_done(state, std::exchange(state.held_frames, {})); });
+}
+
+void mfa::test::TestCompositor::answer_repositions(bool answer)
+{
+    run([&](CompositorState& state) { state.answer_repositions = answer; });
+}
+
+void mfa::test::TestCompositor::run(std::function<void(CompositorState&)> const& function) const
+{
+    std::lock_guard const lock{state->mutex};
+    function(*state);
+    wl_display_flush_clients(state->display);
+}
@@ -0,0 +1,86 @@
+#ifndef TEST_COMPOSITOR_H_
+#define TEST_COMPOSITOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mir_flutter_app::test
+{
+struct CompositorState;
+
+// A minimal Wayland compositor for the runner to connect to, running on a thread of its own and listening on a
+// private socket. It implements enough of wl_compositor, wl_subcompositor, wl_shm, wl_output, wl_seat, xdg_wm_base
+// and mir_shell_v1 for windows to be created, configured and drawn, records what the runner asks of it, and sends
+// input on request. Nothing is shown: buffers are released as soon as they are committed.
+class TestCompositor
+{
+public:
+    enum class Role
+    {
+        none,
+        toplevel,
+        popup,
+        subsurface,
+    };
+
+    // What the runner did with a surface
+    struct Surface
+    {
+        Role role{};
+        // Archetype given through mir_shell_v1, such as "regular" or "satellite", if any
+        std::string archetype;
+        int commits{};
+        int buffer_commits{};
+        int32_t buffer_width{};
+        int32_t buffer_height{};
+        uint32_t buffer_format{};
+        uint32_t configure_serial{};
+        uint32_t acked_serial{};
+        int moves{};
+        int resizes{};
+        // Serial passed with the last move or resize request
+        uint32_t grab_serial{};
+        int repositions{};
+    };
+
+    TestCompositor();
+    ~TestCompositor();
+
+    // Name of the socket to connect to, relative to XDG_RUNTIME_DIR
+    auto socket_name() const -> std::string const&;
+
+    // The surface with the given protocol object ID, unless it was destroyed
+    auto surface(uint32_t id) const -> std::optional<Surface>;
+
+    // Sends xdg_toplevel.configure with the given size and xdg_toplevel_state values, then xdg_surface.configure
+    void configure_toplevel(uint32_t surface_id, int32_t width, int32_t height, std::vector<uint32_t> states = {});
+    void popup_done(uint32_t surface_id);
+
+    void pointer_enter(uint32_t surface_id, double x, double y);
+    void pointer_leave();
+    void pointer_motion(double x, double y);
+    void pointer_button(uint32_t button, bool pressed);
+    void keyboard_enter(uint32_t surface_id);
+    void key(uint32_t key, bool pressed);
+    // Serial of the last input event sent, which the runner passes back with move and resize requests
+    auto input_serial() const -> uint32_t;
+
+    // Frame callbacks are answered as soon as the surface is committed, unless they are held until released
+    void hold_frame_callbacks(bool hold);
+    void release_frame_callbacks();
+    // Reposition requests are answered with repositioned and a new configure, unless they are left unanswered
+    void answer_repositions(bool answer);
+
+private:
+    std::unique_ptr<CompositorState> state;
+
+    // Runs the function on the compositor's state, then sends the events it queued
+    void run(std::function<void(CompositorState&)> const& function) const;
+};
+}
+
+#endif // TEST_COMPOSITOR_H_
@@ -0,0 +1,273 @@
+#include "check.h"
+#include "event_recorder.h"
+#include "event_replayer.h"
+#include "globals.h"
+#include "test_client.h"
+#include "test_compositor.h"
+#include "xdg-shell.h"
+
+#include <linux/input-event-codes.h>
+#include <wayland-util.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace mfa = mir_flutter_app;
+using mfa::test::TestClient;
+using mfa::test::TestCompositor;
+
+namespace
+{
+// Whether the window acked the latest configure and committed a buffer of the given size
+auto drawn_at(TestCompositor const& compositor, MirWindow const* window, int32_t width, int32_t height)
+{
+    return [&compositor, id = TestClient::surface_id(window), width, height]
+        {
+            auto const surface{compositor.surface(id)};
+            return surface &&
+                surface->configure_serial != 0 &&
+                surface->acked_serial == surface->configure_serial &&
+                surface->buffer_width == width &&
+                surface->buffer_height == height;
+        };
+}
+
+// Windows are freed once closed, so they are identified by their surface
+auto closed(TestCompositor const& compositor, uint32_t surface_id)
+{
+    return [&compositor, surface_id] { return !compositor.surface(surface_id); };
+}
+
+// Pooled windows keep their surface, without a role or a buffer
+auto pooled(TestCompositor const& compositor, uint32_t surface_id)
+{
+    return [&compositor, surface_id]
+        {
+            auto const surface{compositor.surface(surface_id)};
+            return surface && surface->role == TestCompositor::Role::none && surface->buffer_width == 0;
+        };
+}
+
+void regular_windows_are_configured_and_drawn(TestCompositor& compositor, TestClient& client)
+{
+    auto* const window{client.create_window(MirWindowArchetype::regular, {400, 300})};
+    CHECK(client.dispatch_until(drawn_at(compositor, window, 400, 300)));
+
+    auto const id{TestClient::surface_id(window)};
+    CHECK(compositor.surface(id)->role == TestCompositor::Role::toplevel);
+    CHECK(compositor.surface(id)->archetype == "regular");
+
+    client.close_window(window);
+    CHECK(client.dispatch_until(closed(compositor, id)));
+}
+
+void configures_resize_windows(TestCompositor& compositor, TestClient& client)
+{
+    auto* const window{client.create_window(MirWindowArchetype::floating_regular, {400, 300})};
+    CHECK(client.dispatch_until(drawn_at(compositor, window, 400, 300)));
+
+    auto const id{TestClient::surface_id(window)};
+    compositor.configure_toplevel(id, 640, 480, {XDG_TOPLEVEL_STATE_ACTIVATED});
+    CHECK(client.dispatch_until(drawn_at(compositor, window, 640, 480)));
+
+    client.close_window(window);
+    CHECK(client.dispatch_until(closed(compositor, id)));
+}
+
+void maximized_windows_are_drawn_into_opaque_buffers(TestCompositor& compositor, TestClient& client)
+{
+    auto* const window{client.create_window(MirWindowArchetype::regular, {400, 300})};
+    CHECK(client.dispatch_until(drawn_at(compositor, window, 400, 300)));
+    auto const id{TestClient::surface_id(window)};
+    CHECK(compositor.surface(id)->buffer_format == WL_SHM_FORMAT_ARGB8888);
+
+    // Square corners leave no transparent pixels
+    compositor.configure_toplevel(id, 800, 600, {XDG_TOPLEVEL_STATE_MAXIMIZED});
+    CHECK(client.dispatch_until(drawn_at(compositor, window, 800, 600)));
+    CHECK(compositor.surface(id)->buffer_format == WL_SHM_FORMAT_XRGB8888);
+
+    compositor.configure_toplevel(id, 400, 300);
+    CHECK(client.dispatch_until(drawn_at(compositor, window, 400, 300)));
+    CHECK(compositor.surface(id)->buffer_format == WL_SHM_FORMAT_ARGB8888);
+
+    client.close_window(window);
+    CHECK(client.dispatch_until(closed(compositor, id)));
+}
+
+void popups_are_drawn_at_their_size_and_pooled_with_their_parent(TestCompositor& compositor, TestClient& client)
+{
+    auto* const parent{client.create_window(MirWindowArchetype::regular, {400, 300})};
+    CHECK(client.dispatch_until(drawn_at(compositor, parent, 400, 300)));
+
+    MirWindowPositioner const positioner{
+        .anchor_rect = {.x = 10, .y = 40, .width = 100, .height = 20},
+        .anchor = MIR_POSITIONER_V1_ANCHOR_BOTTOM_LEFT,
+        .gravity = MIR_POSITIONER_V1_GRAVITY_BOTTOM_RIGHT};
+    auto* const popup{client.create_window(MirWindowArchetype::popup, {200, 100}, parent, positioner)};
+    CHECK(client.dispatch_until(drawn_at(compositor, popup, 200, 100)));
+    auto const parent_id{TestClient::surface_id(parent)};
+    auto const popup_id{TestClient::surface_id(popup)};
+    CHECK(compositor.surface(popup_id)->role == TestCompositor::Role::popup);
+
+    client.close_window(parent);
+    CHECK(client.dispatch_until(pooled(compositor, popup_id)));
+    CHECK(client.dispatch_until(closed(compositor, parent_id)));
+}
+
+void pooled_popups_are_reused_for_the_same_size_class(TestCompositor& compositor, TestClient& client)
+{
+    auto* const parent{client.create_window(MirWindowArchetype::regular, {400, 300})};
+    CHECK(client.dispatch_until(drawn_at(compositor, parent, 400, 300)));
+
+    auto* const popup{client.create_window(MirWindowArchetype::popup, {200, 100}, parent)};
+    CHECK(client.dispatch_until(drawn_at(compositor, popup, 200, 100)));
+    auto const popup_id{TestClient::surface_id(popup)};
+    client.close_window(popup);
+    CHECK(client.dispatch_until(pooled(compositor, popup_id)));
+
+    // 190x90 rounds up to the same multiple of 64 as 200x100
+    auto* const reused{client.create_window(MirWindowArchetype::popup, {190, 90}, parent)};
+    CHECK(reused == popup);
+    CHECK(client.dispatch_until(drawn_at(compositor, reused, 190, 90)));
+    CHECK(compositor.surface(popup_id)->role == TestCompositor::Role::popup);
+
+    auto const parent_id{TestClient::surface_id(parent)};
+    client.close_window(parent);
+    CHECK(client.dispatch_until(pooled(compositor, popup_id)));
+    CHECK(client.dispatch_until(closed(compositor, parent_id)));
+}
+
+void dismissed_popups_reposition_once_reused(TestCompositor& compositor, TestClient& client)
+{
+    auto* const parent{client.create_window(MirWindowArchetype::regular, {400, 300})};
+    CHECK(client.dispatch_until(drawn_at(compositor, parent, 400, 300)));
+
+    auto* const popup{client.create_window(MirWindowArchetype::popup, {200, 100}, parent)};
+    CHECK(client.dispatch_until(drawn_at(compositor, popup, 200, 100)));
+    auto const popup_id{TestClient::surface_id(popup)};
+    auto const repositions{compositor.surface(popup_id)->repositions};
+
+    // The popup is dismissed while a reposition is in flight, so repositioned is never sent
+    compositor.answer_repositions(false);
+    mfa::Globals::instance().reposition_window(popup);
+    CHECK(client.dispatch_until([&] { return compositor.surface(popup_id)->repositions == repositions + 1; }));
+    compositor.popup_done(popup_id);
+    client.dispatch();
+    compositor.answer_repositions(true);
+
+    client.close_window(popup);
+    CHECK(client.dispatch_until(pooled(compositor, popup_id)));
+    auto* const reused{client.create_window(MirWindowArchetype::popup, {200, 100}, parent)};
+    CHECK(reused == popup);
+    CHECK(client.dispatch_until(drawn_at(compositor, reused, 200, 100)));
+
+    // Had the request that was never answered been left in flight, this one would be coalesced into it
+    auto const commits{compositor.surface(popup_id)->buffer_commits};
+    mfa::Globals::instance().reposition_window(reused);
+    CHECK(client.dispatch_until([&] { return compositor.surface(popup_id)->repositions == repositions + 2; }));
+    CHECK(client.dispatch_until([&] { return compositor.surface(popup_id)->buffer_commits > commits; }));
+
+    auto const parent_id{TestClient::surface_id(parent)};
+    client.close_window(parent);
+    CHECK(client.dispatch_until(pooled(compositor, popup_id)));
+    CHECK(client.dispatch_until(closed(compositor, parent_id)));
+}
+
+void presses_on_the_title_bar_move_the_window_with_their_serial(TestCompositor& compositor, TestClient& client)
+{
+    auto* const window{client.create_window(MirWindowArchetype::regular, {400, 300})};
+    CHECK(client.dispatch_until(drawn_at(compositor, window, 400, 300)));
+    auto const id{TestClient::surface_id(window)};
+
+    compositor.pointer_enter(id, 200, 18);
+    compositor.pointer_button(BTN_LEFT, true);
+    auto const serial{compositor.input_serial()};
+    CHECK(client.dispatch_until([&] { return compositor.surface(id)->moves == 1; }));
+    CHECK(compositor.surface(id)->grab_serial == serial);
+
+    compositor.pointer_button(BTN_LEFT, false);
+    compositor.pointer_leave();
+    client.close_window(window);
+    CHECK(client.dispatch_until(closed(compositor, id)));
+}
+
+// Writes a recording of the given events, as EventRecorder does
+auto recording(std::vector<mfa::EventRecorder::Event> const& events) -> std::string
+{
+    auto const path{(std::filesystem::temp_directory_path() / "window_test_recording.mfae").string()};
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file.write(mfa::EventRecorder::magic.data(), mfa::EventRecorder::magic.size());
+    file.write(reinterpret_cast<char const*>(&mfa::EventRecorder::version), sizeof(mfa::EventRecorder::version));
+    for (auto const& event : events)
+    {
+        file.write(reinterpret_cast<char const*>(&event), sizeof(event));
+    }
+    return path;
+}
+
+void replayed_configures_are_applied_and_replayed_presses_do_not_move(TestCompositor& compositor, TestClient& client)
+{
+    using Kind = mfa::EventRecorder::Kind;
+
+    auto* const window{client.create_window(MirWindowArchetype::regular, {400, 300})};
+    CHECK(client.dispatch_until(drawn_at(compositor, window, 400, 300)));
+    auto const id{TestClient::surface_id(window)};
+    auto const acked_serial{compositor.surface(id)->acked_serial};
+
+    // A press on the title bar, then a configure that resizes and activates the window, with serials the
+    // compositor never sent
+    auto const x{static_cast<uint32_t>(wl_fixed_from_double(200))};
+    auto const y{static_cast<uint32_t>(wl_fixed_from_double(18))};
+    auto const path{recording({
+        {.time_us = 0, .kind = Kind::pointer_enter, .padding = {}, .window_id = window->id, .args = {x, y}},
+        {.time_us = 1000, .kind = Kind::pointer_button, .padding = {}, .window_id = window->id,
+         .args = {9999, 1, BTN_LEFT, WL_POINTER_BUTTON_STATE_PRESSED}},
+        {.time_us = 2000, .kind = Kind::pointer_button, .padding = {}, .window_id = window->id,
+         .args = {10000, 2, BTN_LEFT, WL_POINTER_BUTTON_STATE_RELEASED}},
+        {.time_us = 3000, .kind = Kind::pointer_leave, .padding = {}, .window_id = window->id, .args = {}},
+        {.time_us = 4000, .kind = Kind::toplevel_configure, .padding = {}, .window_id = window->id,
+         .args = {600, 400, mfa::EventRecorder::activated_state}},
+        {.time_us = 4000, .kind = Kind::surface_configure, .padding = {}, .window_id = window->id,
+         .args = {9998}}})};
+
+    CHECK(mfa::EventReplayer::start(path));
+    CHECK(client.dispatch_until([] { return !mfa::EventReplayer::replaying(); }));
+    CHECK(client.dispatch_until([&] { return compositor.surface(id)->buffer_width == 600; }));
+    CHECK(compositor.surface(id)->buffer_height == 400);
+    CHECK(compositor.surface(id)->acked_serial == acked_serial);
+    CHECK(compositor.surface(id)->moves == 0);
+
+    std::filesystem::remove(path);
+    client.close_window(window);
+    CHECK(client.dispatch_until(closed(compositor, id)));
+}
+
+void escape_closes_the_focused_window(TestCompositor& compositor, TestClient& client)
+{
+    auto* const window{client.create_window(MirWindowArchetype::regular, {400, 300})};
+    CHECK(client.dispatch_until(drawn_at(compositor, window, 400, 300)));
+
+    auto const id{TestClient::surface_id(window)};
+    compositor.keyboard_enter(id);
+    compositor.key(KEY_ESC, true);
+    compositor.key(KEY_ESC, false);
+    CHECK(client.dispatch_until(closed(compositor, id)));
+}
+}
+
+int main()
+{
+    TestCompositor compositor;
+    TestClient client{compositor};
+
+    regular_windows_are_configured_and_drawn(compositor, client);
+    configures_resize_windows(compositor, client);
+    maximized_windows_are_drawn_into_opaque_buffers(compositor, client);
+    popups_are_drawn_at_their_size_and_pooled_with_their_parent(compositor, client);
+    pooled_popups_are_reused_for_the_same_size_class(compositor, client);
+    dismissed_popups_reposition_once_reused(compositor, client);
+    presses_on_the_title_bar_move_the_window_with_their_serial(compositor, client);
+    escape_closes_the_focused_window(compositor, client);
+    replayed_configures_are_applied_and_replayed_presses_do_not_move(compositor, client);
+}
@@ -0,0 +1,148 @@
+#include "tile_renderer.h"
+
+#include <cairo.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+// Bands per thread, so a thread that draws a cheap band can pick up another one
+int const bands_per_thread{2};
+int const min_band_height{64};
+
+// MIR_FLUTTER_APP_RENDER_THREADS overrides the number of threads, including the calling thread, to compare
+// draw times across core counts
+auto thread_count_for_host() -> int
+{
+    if (auto const* const value{std::getenv("MIR_FLUTTER_APP_RENDER_THREADS")})
+    {
+        return std::max(std::atoi(value), 1);
+    }
+
+    return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+}
+
+namespace mfa = mir_flutter_app;
+
+mfa::TileRenderer::TileRenderer()
+{
+    for (auto i{1}; i < thread_count_for_host(); ++i)
+    {
+        workers.emplace_back([this] { run_worker(); });
+    }
+}
+
+mfa::TileRenderer::~TileRenderer()
+{
+    {
+        std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    job_available.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void mfa::TileRenderer::render(cairo_surface_t* image, std::function<void(cairo_t*)> const& draw)
+{
+    auto const width{cairo_image_surface_get_width(image)};
+    auto const height{cairo_image_surface_get_height(image)};
+
+    if (workers.empty() || width * height < min_pixels)
+    {
+        auto* const context{cairo_create(image)};
+        draw(context);
+        cairo_destroy(context);
+        return;
+    }
+
+    cairo_surface_flush(image);
+
+    auto const band_height{std::max(
+        (height + thread_count() * bands_per_thread - 1) / (thread_count() * bands_per_thread),
+        min_band_height)};
+    auto const band_count{(height + band_height - 1) / band_height};
+
+    auto new_job{std::make_shared<Job>()};
+    new_job->draw = &draw;
+    new_job->data = cairo_image_surface_get_data(image);
+    new_job->format = cairo_image_surface_get_format(image);
+    new_job->width = width;
+    new_job->height = height;
+    new_job->stride = cairo_image_surface_get_stride(image);
+    new_job->band_height = band_height;
+    new_job->band_count = band_count;
+    new_job->next_band = 0;
+    new_job->remaining_bands = band_count;
+
+    {
+        std::lock_guard lock{mutex};
+        job = new_job;
+    }
+    job_available.notify_all();
+
+    draw_bands(*new_job);
+
+    std::unique_lock lock{mutex};
+    job_done.wait(lock, [&] { return new_job->remaining_bands == 0; });
+    job.reset();
+    lock.unlock();
+
+    cairo_surface_mark_dirty(image);
+}
+
+void mfa::TileRenderer::run_worker()
+{
+    std::shared_ptr<Job> last_job;
+
+    while (true)
+    {
+        std::unique_lock lock{mutex};
+        job_available.wait(lock, [&] { return stopping || (job && job != last_job); });
+        if (stopping) return;
+
+        // Holding a reference keeps the job alive even if render returns while this worker looks for a band
+        last_job = job;
+        lock.unlock();
+
+        draw_bands(*last_job);
+    }
+}
+
+void mfa::TileRenderer::draw_bands(Job& job)
+{
+    for (auto band{job.next_band++}; band < job.band_count; band = job.next_band++)
+    {
+        auto const top{band * job.band_height};
+        auto const rows{std::min(job.band_height, job.height - top)};
+
+        // Each band gets an image surface of its own over its rows of the shared memory. Subsurfaces created with
+        // cairo_surface_create_for_rectangle would all draw through the parent surface, which cairo does not allow
+        // to be used from several threads at once.
+        auto* const surface{cairo_image_surface_create_for_data(
+            job.data + static_cast<ptrdiff_t>(top) * job.stride,
+            static_cast<cairo_format_t>(job.format),
+            job.width,
+            rows,
+            job.stride)};
+        auto* const context{cairo_create(surface)};
+        cairo_translate(context, 0, -top);
+
+        (*job.draw)(context);
+
+        cairo_destroy(context);
+        cairo_surface_destroy(surface);
+
+        if (--job.remaining_bands == 0)
+        {
+            std::lock_guard lock{mutex};
+            job_done.notify_all();
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef TILE_RENDERER_H_
+#define TILE_RENDERER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using cairo_surface_t = struct _cairo_surface;
+using cairo_t = struct _cairo;
+
+namespace mir_flutter_app
+{
+// Rasterizes large images in parallel by splitting them into horizontal bands drawn on a worker pool.
+// The calling thread draws bands too and returns only once all of them are done.
+class TileRenderer
+{
+public:
+    TileRenderer(TileRenderer const&) = delete;
+    TileRenderer(TileRenderer&&) = delete;
+    TileRenderer& operator=(TileRenderer const&) = delete;
+    TileRenderer& operator=(TileRenderer&&) = delete;
+    ~TileRenderer();
+
+    static TileRenderer& instance()
+    {
+        static TileRenderer instance;
+        return instance;
+    }
+
+    // Images with fewer pixels are not worth splitting
+    static int const min_pixels{1 << 20};
+
+    // Calls draw once per band of the image surface with a context clipped to the band. The context uses the
+    // coordinates of the whole image, so draw does not need to know about bands.
+    void render(cairo_surface_t* image, std::function<void(cairo_t*)> const& draw);
+
+    auto thread_count() const -> int { return static_cast<int>(workers.size()) + 1; }
+
+private:
+    struct Job
+    {
+        std::function<void(cairo_t*)> const* draw;
+        unsigned char* data;
+        int format;
+        int width;
+        int height;
+        int stride;
+        int band_height;
+        int band_count;
+        std::atomic<int> next_band;
+        std::atomic<int> remaining_bands;
+    };
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::condition_variable job_done;
+    std::shared_ptr<Job> job;
+    bool stopping{};
+
+    void run_worker();
+    void draw_bands(Job& job);
+
+    TileRenderer();
+};
+}
+
+#endif // TILE_RENDERER_H_
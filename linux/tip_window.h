@@ -12,7 +12,7 @@ public:
     ~TipWindow() override = default;
 
 protected:
-    void draw_new_content(Buffer* buffer) override;
+    auto content_painter() const -> Painter override;
 
     TipWindow(TipWindow&&) = default;
     TipWindow& operator=(TipWindow&&) = default;
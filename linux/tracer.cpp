@@ -0,0 +1,101 @@
+#include "tracer.h"
+#include "logger.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+
+namespace mfa = mir_flutter_app;
+
+mfa::Tracer::Tracer()
+{
+    // Constructed first so it is destroyed last and can still report failures to write the trace at exit
+    Logger::instance();
+
+    if (auto const* const path{std::getenv("MIR_FLUTTER_APP_TRACE")})
+    {
+        path_ = path;
+    }
+}
+
+mfa::Tracer::~Tracer()
+{
+    if (enabled())
+    {
+        write();
+    }
+}
+
+void mfa::Tracer::instant(char const* name, int window_id)
+{
+    record(name, window_id < 0 ? 'i' : 'n', window_id);
+}
+
+void mfa::Tracer::begin(char const* name) { record(name, 'B', -1); }
+
+void mfa::Tracer::end(char const* name) { record(name, 'E', -1); }
+
+void mfa::Tracer::begin_async(char const* name, int window_id) { record(name, 'b', window_id); }
+
+void mfa::Tracer::end_async(char const* name, int window_id) { record(name, 'e', window_id); }
+
+void mfa::Tracer::record(char const* name, char phase, int window_id)
+{
+    if (!enabled()) return;
+
+    auto const timestamp{std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch())};
+
+    // Once the buffer is full, the oldest events are overwritten
+    events[recorded++ % capacity] = {
+        .name = name,
+        .phase = phase,
+        .window_id = window_id,
+        .thread = static_cast<uint32_t>(gettid()),
+        .timestamp = timestamp.count()};
+}
+
+auto mfa::Tracer::write() const -> bool
+{
+    std::ofstream file{path_};
+    if (!file)
+    {
+        MFA_LOG(error, "tracer", "Failed to open trace file ", path_);
+        return false;
+    }
+
+    auto const pid{getpid()};
+    auto const count{recorded.load()};
+    auto const first{count > capacity ? count - capacity : 0};
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (auto i{first}; i < count; ++i)
+    {
+        auto const& event{events[i % capacity]};
+        file << (i == first ? "\n" : ",\n")
+             << "{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase << "\",\"ts\":" << event.timestamp
+             << ",\"pid\":" << pid << ",\"tid\":" << event.thread;
+
+        switch (event.phase)
+        {
+            case 'i':
+                file << ",\"s\":\"p\"";
+                break;
+            case 'b':
+            case 'n':
+            case 'e':
+                // Window events are grouped by window; the others share a single startup track
+                file << ",\"cat\":\"" << (event.window_id < 0 ? "startup" : "window")
+                     << "\",\"id\":" << std::max(event.window_id, 0);
+                break;
+        }
+
+        file << "}";
+    }
+    file << "\n]}\n";
+
+    return static_cast<bool>(file);
+}
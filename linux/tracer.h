@@ -0,0 +1,64 @@
+#ifndef TRACER_H_
+#define TRACER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace mir_flutter_app
+{
+// Records startup and window lifecycle events with monotonic timestamps into a fixed-size ring buffer, and writes
+// them in the Chrome trace event format, which chrome://tracing and Perfetto can open. Tracing is enabled by
+// setting MIR_FLUTTER_APP_TRACE to the path of the file to write. The file is written at exit and on request.
+class Tracer
+{
+public:
+    Tracer(Tracer const&) = delete;
+    Tracer(Tracer&&) = delete;
+    Tracer& operator=(Tracer const&) = delete;
+    Tracer& operator=(Tracer&&) = delete;
+    ~Tracer();
+
+    static Tracer& instance()
+    {
+        static Tracer instance;
+        return instance;
+    }
+
+    auto enabled() const -> bool { return !path_.empty(); }
+    auto path() const -> std::string const& { return path_; }
+
+    // Only the pointers to the names are stored, so they must be string literals. Events with a window ID are
+    // shown on a track of their own for that window.
+    void instant(char const* name, int window_id = -1);
+    void begin(char const* name);
+    void end(char const* name);
+    void begin_async(char const* name, int window_id = -1);
+    void end_async(char const* name, int window_id = -1);
+
+    auto write() const -> bool;
+
+private:
+    struct Event
+    {
+        char const* name;
+        char phase;
+        int window_id;
+        uint32_t thread;
+        int64_t timestamp;
+    };
+
+    static size_t const capacity{4096};
+
+    std::string path_;
+    std::array<Event, capacity> events{};
+    std::atomic<uint64_t> recorded{};
+
+    void record(char const* name, char phase, int window_id);
+
+    Tracer();
+};
+}
+
+#endif // TRACER_H_
@@ -1,34 +1,91 @@
 #include "window.h"
 #include "globals.h"
+#include "logger.h"
+#include "memory_budget.h"
+#include "mir_window.h"
+#include "render_thread.h"
+#include "stats.h"
+#include "tile_renderer.h"
+#include "tracer.h"
 
 #include <wayland-client.h>
 
+#include <glib.h>
+
 #include <cairo.h>
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <string_view>
 
 namespace
 {
-auto make_shm_pool(wl_shm* shm, int size, void** data) -> wl_shm_pool*
+// Adds a width x height rectangle with rounded corners to the region. With inner set, only the pixels fully
+// covered by the shape are added; otherwise, every pixel the shape touches is.
+void add_rounded_rect(
+    wl_region* region,
+    int32_t width,
+    int32_t height,
+    double top_corner_radius,
+    double bottom_corner_radius,
+    bool inner)
 {
-    int fd{memfd_create("make_shm_pool", MFD_CLOEXEC)};
-    if (fd < 0) return nullptr;
-
-    posix_fallocate(fd, 0, size);
+    auto const corner_inset{[inner](double radius, int32_t row)
+        {
+            // Vertical distance from the corner's center to the row edge farthest from it (inner) or closest to it
+            auto const dy{std::max(radius - (inner ? row : row + 1), 0.0)};
+            auto const dx{radius - std::sqrt(std::max(radius * radius - dy * dy, 0.0))};
+            return static_cast<int32_t>(inner ? std::ceil(dx) : std::floor(dx));
+        }};
+    auto const row_inset{[&](int32_t row)
+        {
+            if (row < top_corner_radius) return corner_inset(top_corner_radius, row);
+            if (height - 1 - row < bottom_corner_radius) return corner_inset(bottom_corner_radius, height - 1 - row);
+            return 0;
+        }};
 
-    *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-    if (*data == MAP_FAILED)
+    // Consecutive rows with the same inset are merged into a single rectangle
+    auto band_start{0};
+    auto band_inset{row_inset(0)};
+    for (auto row{1}; row <= height; ++row)
     {
-        close(fd);
-        return nullptr;
-    }
+        auto const inset{row < height ? row_inset(row) : -1};
+        if (inset == band_inset) continue;
 
-    wl_shm_pool* pool{wl_shm_create_pool(shm, fd, size)};
+        if (width > 2 * band_inset)
+        {
+            wl_region_add(region, band_inset, band_start, width - 2 * band_inset, row - band_start);
+        }
+        band_start = row;
+        band_inset = inset;
+    }
+}
 
-    close(fd);
+// How long a window can go without being repainted before its buffers are freed, 0 to keep them
+auto hidden_grace_period() -> std::chrono::milliseconds
+{
+    static auto const grace_period{[]
+        {
+            std::chrono::milliseconds const default_period{5000};
+            auto const* const value{std::getenv("MIR_FLUTTER_APP_HIDDEN_GRACE_MS")};
+            if (!value) return default_period;
 
-    return pool;
+            std::string_view const period{value};
+            std::chrono::milliseconds::rep ms{};
+            if (auto const [end, error]{std::from_chars(period.data(), period.data() + period.size(), ms)};
+                error != std::errc{} || end != period.data() + period.size())
+            {
+                MFA_LOG(warning, "memory", "Invalid MIR_FLUTTER_APP_HIDDEN_GRACE_MS '", value, "', using ",
+                    default_period.count(), " ms");
+                return default_period;
+            }
+            return std::chrono::milliseconds{ms};
+        }()};
+    return grace_period;
 }
 }
 
@@ -36,43 +93,200 @@ namespace mfa = mir_flutter_app;
 
 mfa::Window::Window(wl_surface* surface, int32_t width, int32_t height) :
     surface{surface},
+    frame_surface{static_cast<wl_surface*>(wl_proxy_create_wrapper(surface))},
     width_{width},
     height_{height}
 {
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(frame_surface), Globals::instance().event_queue());
+
+    // Buffers are allocated on first use, once the derived class can tell whether it is opaque
     for (auto& buffer_ : buffers)
     {
-        prepare_buffer(buffer_);
+        buffer_.available = true;
     }
 }
 
 mfa::Window::~Window()
 {
+    discard_pending_frame();
+    destroy_frame_callbacks();
+    stop_hidden_timer();
+
+    for (auto& buffer_ : buffers)
+    {
+        destroy_buffer(buffer_);
+    }
+
+    if (opaque_region) wl_region_destroy(opaque_region);
+    if (input_region) wl_region_destroy(input_region);
+    wl_proxy_wrapper_destroy(frame_surface);
+}
+
+void mfa::Window::discard_pending_frame()
+{
+    if (!pending_frame) return;
+
+    // The window lets go of the buffer rather than wait for the render thread to finish drawing into it
+    RenderThread::instance().cancel(pending_frame, [buffer_{*pending_buffer}]() mutable { destroy_buffer(buffer_); });
+    *pending_buffer = {.available = true};
+    pending_frame = 0;
+    pending_buffer = nullptr;
+}
+
+void mfa::Window::unmap()
+{
+    discard_pending_frame();
+    need_to_draw = false;
+    committed = false;
+
+    // Otherwise the pooled window would be taken as hidden and lose the buffers it is kept for
+    destroy_frame_callbacks();
+    stop_hidden_timer();
+
+    wl_surface_attach(surface, nullptr, 0, 0);
+    wl_surface_commit(surface);
+}
+
+auto mfa::Window::buffer_count() const -> int
+{
+    return std::ranges::count_if(buffers, [](Buffer const& buffer_) { return buffer_.memory.buffer != nullptr; });
+}
+
+auto mfa::Window::buffer_bytes() const -> size_t
+{
+    size_t bytes{0};
+    for (auto const& buffer_ : buffers)
+    {
+        bytes += buffer_.memory.size;
+    }
+    return bytes;
+}
+
+auto mfa::Window::drop_back_buffers() -> size_t
+{
+    size_t freed{0};
     for (auto& buffer_ : buffers)
     {
-        cairo_surface_destroy(buffer_.cairo_surface);
-        cairo_destroy(buffer_.cairo_context);
-        wl_buffer_destroy(buffer_.buffer);
+        // Buffers being drawn on the render thread or held by the compositor are not available
+        if (buffer_.available && buffer_.memory.buffer && &buffer_ != last_presented)
+        {
+            freed += buffer_.memory.size;
+            destroy_buffer(buffer_);
+        }
     }
+    return freed;
 }
 
 void mfa::Window::redraw()
 {
-    static wl_callback_listener const frame_listener{
-        .done = [](void* ctx, auto... args) { static_cast<Window*>(ctx)->handle_frame_callback(args...); }};
+    Stats::instance().increment(Stats::Counter::redraws);
 
-    if (auto* const buffer_{find_free_buffer()})
+    // Drawn again on the next frame callback after the pending frame is committed
+    if (pending_frame)
     {
-        draw_new_content(buffer_);
+        Stats::instance().increment(Stats::Counter::coalesced_redraws);
+        need_to_draw = true;
+        return;
+    }
 
-        auto* const new_frame_signal{wl_surface_frame(surface)};
-        wl_callback_add_listener(new_frame_signal, &frame_listener, this);
-        wl_surface_attach(surface, buffer_->buffer, 0, 0);
-        wl_surface_commit(surface);
-        need_to_draw = false;
+    auto* const buffer_{find_free_buffer()};
+    if (!buffer_)
+    {
+        need_to_draw = true;
+        return;
+    }
+
+    // Regions are double-buffered state, so setting them now still applies them along with this buffer
+    if (need_to_update_regions)
+    {
+        update_regions();
+    }
+    need_to_draw = false;
+
+    auto painter{content_painter()};
+    pending_frame = RenderThread::instance().submit(
+        [buffer_copy{*buffer_}, painter] { draw(buffer_copy, painter); },
+        [this, buffer_] { present(*buffer_); });
+    if (pending_frame)
+    {
+        pending_buffer = buffer_;
     }
     else
     {
-        need_to_draw = true;
+        draw(*buffer_, painter);
+        present(*buffer_);
+    }
+}
+
+void mfa::Window::draw(Buffer buffer, Painter const& painter)
+{
+    Stats::Timer const timer{Stats::Histogram::draw_time};
+
+    auto& backend{Globals::instance().buffer_backend()};
+    backend.begin_access(buffer.memory);
+    if (buffer.width * buffer.height < TileRenderer::min_pixels)
+    {
+        painter(&buffer);
+    }
+    else
+    {
+        TileRenderer::instance().render(
+            buffer.cairo_surface,
+            [&buffer, &painter](cairo_t* context)
+            {
+                auto band{buffer};
+                band.cairo_context = context;
+                painter(&band);
+            });
+    }
+    cairo_surface_flush(buffer.cairo_surface);
+    backend.end_access(buffer.memory);
+
+    // Every draw repaints the whole buffer
+    Stats::instance().add(Stats::Counter::bytes_drawn, static_cast<uint64_t>(buffer.memory.stride) * buffer.height);
+}
+
+void mfa::Window::present(Buffer& buffer)
+{
+    static wl_callback_listener const frame_listener{
+        .done = [](void* ctx, auto... args) { static_cast<Window*>(ctx)->handle_frame_callback(args...); }};
+
+    pending_frame = 0;
+    pending_buffer = nullptr;
+    last_presented = &buffer;
+
+    auto* const new_frame_signal{wl_surface_frame(frame_surface)};
+    wl_callback_add_listener(new_frame_signal, &frame_listener, this);
+    frame_callbacks.push_back(new_frame_signal);
+    last_frame_request = std::chrono::steady_clock::now();
+    if (!hidden_timer) start_hidden_timer(hidden_grace_period());
+    wl_surface_attach(surface, buffer.memory.buffer, 0, 0);
+    auto const covered{std::min(covered_height(), buffer.height)};
+    wl_surface_damage(surface, 0, covered, buffer.width, buffer.height - covered);
+    wl_surface_commit(surface);
+    handle_presented();
+
+    if (!committed)
+    {
+        committed = true;
+        if (auto* const mir_window{Globals::instance().window_for(surface)})
+        {
+            Tracer::instance().instant("first commit", mir_window->id);
+            Tracer::instance().end_async("window", mir_window->id);
+
+            auto const time_to_commit{std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - mir_window->created)};
+            Stats::instance().record(Stats::Histogram::first_commit_time, time_to_commit);
+
+            // The first window pays for whatever was not prewarmed
+            static bool first_window{true};
+            if (first_window)
+            {
+                first_window = false;
+                MFA_LOG(info, "window", "First window shown ", time_to_commit.count() / 1000.0,
+                    " ms after it was requested");
+            }
+        }
     }
 }
 
@@ -81,11 +295,20 @@ void mfa::Window::resize(int32_t width, int32_t height)
     if (width_ == width && height_ == height) return;
     if (width > 0) width_ = width;
     if (height > 0) height_ = height;
+    need_to_update_regions = true;
+}
+
+void mfa::Window::set_suspended(bool suspended_)
+{
+    suspended = suspended_;
+    if (suspended && !hidden_timer) start_hidden_timer(hidden_grace_period());
 }
 
 void mfa::Window::handle_frame_callback(wl_callback* callback, uint32_t /*time*/)
 {
+    std::erase(frame_callbacks, callback);
     wl_callback_destroy(callback);
+    Stats::instance().increment(Stats::Counter::frame_callbacks);
 
     if (need_to_draw)
     {
@@ -93,62 +316,202 @@ void mfa::Window::handle_frame_callback(wl_callback* callback, uint32_t /*time*/
     }
 }
 
+void mfa::Window::destroy_frame_callbacks()
+{
+    for (auto* const callback : frame_callbacks)
+    {
+        wl_callback_destroy(callback);
+    }
+    frame_callbacks.clear();
+}
+
+void mfa::Window::start_hidden_timer(std::chrono::milliseconds delay)
+{
+    if (hidden_grace_period() <= std::chrono::milliseconds::zero()) return;
+
+    hidden_timer = g_timeout_add(
+        static_cast<guint>(delay.count()),
+        [](gpointer ctx) -> gboolean
+        {
+            static_cast<Window*>(ctx)->handle_hidden_timer();
+            return G_SOURCE_REMOVE;
+        },
+        this);
+}
+
+void mfa::Window::stop_hidden_timer()
+{
+    if (!hidden_timer) return;
+
+    g_source_remove(hidden_timer);
+    hidden_timer = 0;
+}
+
+void mfa::Window::handle_hidden_timer()
+{
+    hidden_timer = 0;
+
+    // A single timer is kept per window rather than one per frame, so it is started again for the time remaining
+    // since the last frame was requested
+    auto const starved_for{std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - last_frame_request)};
+    if (!suspended && !frame_callbacks.empty() && starved_for < hidden_grace_period())
+    {
+        start_hidden_timer(hidden_grace_period() - starved_for);
+        return;
+    }
+
+    if (suspended || !frame_callbacks.empty())
+    {
+        release_buffers();
+    }
+}
+
+void mfa::Window::release_buffers()
+{
+    discard_pending_frame();
+
+    // The compositor keeps its own reference to the memory of the buffer on screen, which is never written to
+    // again, so even buffers it still holds can be destroyed
+    size_t released{0};
+    for (auto& buffer_ : buffers)
+    {
+        released += buffer_.memory.size;
+        destroy_buffer(buffer_);
+    }
+    last_presented = nullptr;
+    if (!released) return;
+
+    // Drawn again on the next frame callback or configure, unless the surface has been unmapped meanwhile
+    if (committed) need_to_draw = true;
+
+    Stats::instance().add(Stats::Counter::hidden_bytes_released, released);
+    MFA_LOG(debug, "memory", "Released ", released, " bytes of buffers of a hidden window");
+}
+
 void mfa::Window::update_free_buffers(wl_buffer* buffer)
 {
     for (auto& buffer_ : buffers)
     {
-        if (buffer_.buffer == buffer)
+        if (buffer_.memory.buffer == buffer)
         {
             buffer_.available = true;
         }
     }
 }
 
-void mfa::Window::prepare_buffer(Buffer& buffer)
+void mfa::Window::prepare_buffer(Buffer& buffer, uint32_t format)
 {
     static wl_buffer_listener const buffer_listener{
         .release = [](void* ctx, auto... args) { static_cast<Window*>(ctx)->update_free_buffers(args...); }};
 
-    auto const stride{width_ * Window::pixel_size};
-
-    void* pool_data;
-    wl_shm_pool* shm_pool{make_shm_pool(Globals::instance().shm(), width_ * height_ * Window::pixel_size, &pool_data)};
+    buffer.memory = Globals::instance().buffer_backend().allocate(width_, height_, format);
+    if (!buffer.memory.buffer) return;
+    MemoryBudget::instance().add(buffer.memory.size);
 
-    buffer.buffer = wl_shm_pool_create_buffer(shm_pool, 0, width_, height_, stride, WL_SHM_FORMAT_ARGB8888);
     buffer.available = true;
     buffer.width = width_;
     buffer.height = height_;
-    buffer.content_area = pool_data;
+    buffer.format = format;
 
     buffer.cairo_surface = cairo_image_surface_create_for_data(
-        static_cast<unsigned char*>(pool_data),
-        CAIRO_FORMAT_ARGB32,
+        static_cast<unsigned char*>(buffer.memory.data),
+        format == WL_SHM_FORMAT_XRGB8888 ? CAIRO_FORMAT_RGB24 : CAIRO_FORMAT_ARGB32,
         width_,
         height_,
-        stride);
+        buffer.memory.stride);
     buffer.cairo_context = cairo_create(buffer.cairo_surface);
 
-    wl_buffer_add_listener(buffer.buffer, &buffer_listener, this);
-    wl_shm_pool_destroy(shm_pool);
+    wl_buffer_add_listener(buffer.memory.buffer, &buffer_listener, this);
+}
+
+void mfa::Window::destroy_buffer(Buffer& buffer)
+{
+    if (!buffer.memory.buffer) return;
+
+    cairo_destroy(buffer.cairo_context);
+    cairo_surface_destroy(buffer.cairo_surface);
+    MemoryBudget::instance().remove(buffer.memory.size);
+    Globals::instance().buffer_backend().destroy(buffer.memory);
+    buffer = {.available = true};
 }
 
 auto mfa::Window::find_free_buffer() -> Buffer*
 {
+    auto& backend{Globals::instance().buffer_backend()};
+    auto const format{is_opaque() && backend.supports_format(WL_SHM_FORMAT_XRGB8888) ?
+        WL_SHM_FORMAT_XRGB8888 :
+        WL_SHM_FORMAT_ARGB8888};
+
     for (auto& buffer_ : buffers)
     {
         if (buffer_.available)
         {
-            if (buffer_.width != width_ || buffer_.height != height_)
+            if (!buffer_.memory.buffer ||
+                buffer_.width != width_ ||
+                buffer_.height != height_ ||
+                buffer_.format != format)
             {
-                cairo_surface_destroy(buffer_.cairo_surface);
-                cairo_destroy(buffer_.cairo_context);
-                wl_buffer_destroy(buffer_.buffer);
-                prepare_buffer(buffer_);
+                destroy_buffer(buffer_);
+                prepare_buffer(buffer_, format);
+                Stats::instance().increment(Stats::Counter::buffer_allocations);
+                if (!buffer_.memory.buffer) return nullptr;
+
+                if (MemoryBudget::instance().exceeded())
+                {
+                    Globals::instance().trim_buffers(this);
+                }
             }
 
             buffer_.available = false;
             return &buffer_;
         }
     }
+
+    Stats::instance().increment(Stats::Counter::no_free_buffer);
     return nullptr;
 }
+
+auto mfa::Window::is_opaque() const -> bool
+{
+    auto const outline{shape()};
+    return !outline.translucent && outline.top_corner_radius <= 0 && outline.bottom_corner_radius <= 0;
+}
+
+void mfa::Window::update_regions()
+{
+    auto* const compositor{Globals::instance().compositor()};
+    auto const outline{shape()};
+
+    if (opaque_region) wl_region_destroy(opaque_region);
+    opaque_region = wl_compositor_create_region(compositor);
+    if (!outline.translucent)
+    {
+        add_rounded_rect(
+            opaque_region,
+            width_,
+            height_,
+            outline.top_corner_radius,
+            outline.bottom_corner_radius,
+            true);
+    }
+
+    // Clicks on the transparent corners go to whatever is below the window
+    if (input_region) wl_region_destroy(input_region);
+    input_region = wl_compositor_create_region(compositor);
+    if (outline.accepts_input)
+    {
+        add_rounded_rect(
+            input_region,
+            width_,
+            height_,
+            outline.top_corner_radius,
+            outline.bottom_corner_radius,
+            false);
+    }
+
+    wl_surface_set_opaque_region(surface, opaque_region);
+    wl_surface_set_input_region(surface, input_region);
+
+    need_to_update_regions = false;
+}
@@ -1,13 +1,19 @@
 #ifndef WINDOW_H_
 #define WINDOW_H_
 
+#include "buffer_backend.h"
+
 #include <array>
+#include <chrono>
 #include <cstdint>
+#include <functional>
+#include <vector>
 
 struct wl_buffer;
 struct wl_callback;
 struct wl_keyboard;
 struct wl_pointer;
+struct wl_region;
 struct wl_surface;
 
 using cairo_surface_t = struct _cairo_surface;
@@ -26,6 +32,25 @@ public:
     auto width() const -> int32_t { return width_; }
     auto height() const -> int32_t { return height_; }
 
+    // Whether a frame is being drawn and has yet to be committed to the surface
+    auto has_pending_frame() const -> bool { return pending_frame != 0; }
+    // Drops the frame being drawn, if any, so it is never committed to the surface. Its buffer is released once the
+    // render thread is done with it.
+    void discard_pending_frame();
+    // Takes the buffer off the surface, so it can be given a new role. The buffers are kept for when it is shown
+    // again, and the frame callbacks still outstanding are dropped, as an unmapped surface may never get them.
+    void unmap();
+
+    auto buffer_count() const -> int;
+    auto buffer_bytes() const -> size_t;
+    // Frees the buffers the compositor has released, except the one presented last, which is most likely to be
+    // drawn into next. They are allocated again when needed. Returns the number of bytes freed.
+    auto drop_back_buffers() -> size_t;
+
+    // Pointer coordinates are in surface-local pixels
+    virtual void handle_mouse_enter(wl_pointer* pointer, uint32_t serial, double x, double y) {};
+    virtual void handle_mouse_leave(wl_pointer* pointer, uint32_t serial) {};
+    virtual void handle_mouse_motion(wl_pointer* pointer, uint32_t time, double x, double y) {};
     virtual void handle_mouse_button(
         wl_pointer* pointer,
         uint32_t serial,
@@ -47,22 +72,44 @@ public:
         uint32_t group) {};
 
 protected:
-    static int const pixel_size{4};
-
     struct Buffer
     {
-        wl_buffer* buffer{};
+        BufferBackend::Memory memory{};
         bool available{};
         int width{};
         int height{};
-        void* content_area{};
+        uint32_t format{};
 
         cairo_surface_t* cairo_surface;
         cairo_t* cairo_context;
     };
 
+    // Paints a frame into a buffer on the render thread. It is made on the main thread when the frame is submitted
+    // and only uses what it captured then, so the window can change, or be destroyed, while it runs.
+    using Painter = std::function<void(Buffer* buffer)>;
+
+    // Outline of what content_painter paints: the whole surface with rounded corners. Pixels
+    // inside the outline are fully opaque unless the shape is translucent.
+    struct Shape
+    {
+        double top_corner_radius{};
+        double bottom_corner_radius{};
+        bool translucent{};
+        bool accepts_input{true};
+    };
+
     void redraw();
     void resize(int32_t width, int32_t height);
+    // Set while the compositor is not repainting the window. If it stays suspended for the grace period, its
+    // buffers are freed and the next redraw allocates them again.
+    void set_suspended(bool suspended);
+    // Called when shape() changes while the size stays the same, so the next redraw updates the regions and picks
+    // the buffer format again
+    void update_shape() { need_to_update_regions = true; }
+
+    virtual auto shape() const -> Shape { return {.translucent = true}; }
+    // Height of a band at the top of the surface that is covered by a subsurface and never damaged
+    virtual auto covered_height() const -> int32_t { return 0; }
 
     Window(Window&&) = default;
     Window& operator=(Window&&) = default;
@@ -71,19 +118,47 @@ private:
     static int const num_buffers{2};
 
     wl_surface* surface;
+    // Proxy wrapper that creates the frame callbacks on the runner's event queue, even for surfaces made by GDK
+    wl_surface* frame_surface;
     int width_;
     int height_;
 
     std::array<Buffer, Window::num_buffers> buffers{};
     bool need_to_draw{true};
-
+    wl_region* opaque_region{};
+    wl_region* input_region{};
+    bool need_to_update_regions{true};
+    uint64_t pending_frame{};
+    Buffer* pending_buffer{};
+    bool committed{};
+    Buffer const* last_presented{};
+
+    // Compositors stop sending frame callbacks to windows that are not visible, so one outstanding for the grace
+    // period is taken as the window being hidden, even without the suspended state
+    bool suspended{};
+    std::vector<wl_callback*> frame_callbacks;
+    std::chrono::steady_clock::time_point last_frame_request{};
+    unsigned hidden_timer{};
+
+    static void draw(Buffer buffer, Painter const& painter);
+    void present(Buffer& buffer);
     void handle_frame_callback(wl_callback* callback, uint32_t time);
+    void destroy_frame_callbacks();
+    void start_hidden_timer(std::chrono::milliseconds delay);
+    void stop_hidden_timer();
+    void handle_hidden_timer();
+    void release_buffers();
 
     void update_free_buffers(wl_buffer* buffer);
-    void prepare_buffer(Buffer& b);
+    void prepare_buffer(Buffer& b, uint32_t format);
+    static void destroy_buffer(Buffer& b);
     auto find_free_buffer() -> Buffer*;
+    auto is_opaque() const -> bool;
+    void update_regions();
 
-    virtual void draw_new_content(Buffer* buffer) = 0;
+    virtual auto content_painter() const -> Painter = 0;
+    // Called after each frame is committed to the surface
+    virtual void handle_presented() {}
 
     Window(Window const&) = delete;
     Window& operator=(Window const&) = delete;
@@ -0,0 +1,80 @@
+#include "window_pool.h"
+#include "logger.h"
+#include "stats.h"
+#include "xdg_popup_window.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <string_view>
+
+namespace mfa = mir_flutter_app;
+
+mfa::WindowPool::WindowPool()
+{
+    if (auto const* const value{std::getenv("MIR_FLUTTER_APP_WINDOW_POOL_SIZE")})
+    {
+        std::string_view const size{value};
+        size_t parsed{};
+        if (auto const [end, error]{std::from_chars(size.data(), size.data() + size.size(), parsed)};
+            error == std::errc{} && end == size.data() + size.size())
+        {
+            capacity = parsed;
+        }
+        else
+        {
+            MFA_LOG(warning, "pool", "Invalid MIR_FLUTTER_APP_WINDOW_POOL_SIZE '", value, "', keeping ", capacity,
+                " windows");
+        }
+    }
+    entries.reserve(capacity);
+}
+
+auto mfa::WindowPool::release(MirWindow* window) -> bool
+{
+    if (capacity == 0) return false;
+    if (window->archetype != MirWindowArchetype::popup && window->archetype != MirWindowArchetype::tip) return false;
+
+    std::get<std::unique_ptr<XdgPopupWindow>>(window->window)->detach();
+    if (release_handler) release_handler(window);
+    // Without an application, the window is not reported as closed again when it is destroyed
+    gtk_window_set_application(GTK_WINDOW(window), nullptr);
+
+    if (entries.size() == capacity)
+    {
+        auto* const evicted{entries.front().window};
+        entries.erase(entries.begin());
+        std::get<std::unique_ptr<XdgPopupWindow>>(evicted->window).reset();
+        evicted->base_window = nullptr;
+        gtk_widget_destroy(GTK_WIDGET(evicted));
+    }
+    entries.push_back({
+        .archetype = window->archetype,
+        .width_class = size_class(window->size.width),
+        .height_class = size_class(window->size.height),
+        .window = window});
+
+    MFA_LOG(debug, "pool", "Pooled window ", window->id, " (", entries.size(), "/", capacity, ")");
+    return true;
+}
+
+auto mfa::WindowPool::acquire(MirWindowArchetype archetype, MirWindowSize size) -> MirWindow*
+{
+    // The most recently closed window is the most likely to still have buffers of the right size
+    auto const entry{std::find_if(entries.rbegin(), entries.rend(), [&](Entry const& pooled)
+        {
+            return pooled.archetype == archetype &&
+                pooled.width_class == size_class(size.width) &&
+                pooled.height_class == size_class(size.height);
+        })};
+    if (entry == entries.rend())
+    {
+        Stats::instance().increment(Stats::Counter::window_pool_misses);
+        return nullptr;
+    }
+
+    Stats::instance().increment(Stats::Counter::window_pool_hits);
+    auto* const window{entry->window};
+    entries.erase(std::next(entry).base());
+    return window;
+}
@@ -0,0 +1,62 @@
+#ifndef WINDOW_POOL_H_
+#define WINDOW_POOL_H_
+
+#include "mir_window.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mir_flutter_app
+{
+// Keeps closed popup and tip windows, with their realized surfaces and allocated buffers, so the next window of the
+// same archetype and size class reuses them instead of going through GTK and allocating buffers again. The pool
+// holds up to MIR_FLUTTER_APP_WINDOW_POOL_SIZE windows (8 by default, 0 disables it); the least recently closed
+// one is destroyed when it is full.
+class WindowPool
+{
+public:
+    WindowPool(WindowPool const&) = delete;
+    WindowPool(WindowPool&&) = delete;
+    WindowPool& operator=(WindowPool const&) = delete;
+    WindowPool& operator=(WindowPool&&) = delete;
+    ~WindowPool() = default;
+
+    static WindowPool& instance()
+    {
+        static WindowPool instance;
+        return instance;
+    }
+
+    // Called with each window the pool takes, to do what is otherwise done when a window is destroyed
+    void set_release_handler(void (*handler)(MirWindow*)) { release_handler = handler; }
+
+    // Takes a closed window. Returns false if it cannot be pooled and must be destroyed instead.
+    auto release(MirWindow* window) -> bool;
+    // Returns a pooled window for the archetype and size, or nullptr if there is none
+    auto acquire(MirWindowArchetype archetype, MirWindowSize size) -> MirWindow*;
+
+private:
+    struct Entry
+    {
+        MirWindowArchetype archetype;
+        int32_t width_class;
+        int32_t height_class;
+        MirWindow* window;
+    };
+
+    // Windows whose sizes round up to the same multiple of this share a size class
+    static int32_t const size_class_step{64};
+
+    size_t capacity{8};
+    // Least recently closed first
+    std::vector<Entry> entries;
+    void (*release_handler)(MirWindow*){};
+
+    static auto size_class(int32_t size) -> int32_t { return (size + size_class_step - 1) / size_class_step; }
+
+    WindowPool();
+};
+}
+
+#endif // WINDOW_POOL_H_
@@ -1,9 +1,12 @@
 #include "xdg_popup_window.h"
+#include "event_recorder.h"
 #include "globals.h"
+#include "logger.h"
 #include "mir_window.h"
+#include "stats.h"
+#include "tracer.h"
 #include "xdg-shell.h"
 
-#include <iostream>
 
 namespace mfa = mir_flutter_app;
 
@@ -14,28 +17,69 @@ mfa::XdgPopupWindow::XdgPopupWindow(
     xdg_surface* parent,
     xdg_positioner* positioner) :
     Window{surface, width, height},
-    xdgsurface{xdg_wm_base_get_xdg_surface(Globals::instance().wm_base(), static_cast<wl_surface*>(*this))},
-    xdgpopup{xdg_surface_get_popup(xdgsurface, parent, positioner)}
+    xdgsurface{},
+    xdgpopup{}
+{
+    create_role(parent, positioner);
+}
+
+mfa::XdgPopupWindow::~XdgPopupWindow()
+{
+    if (xdgpopup)
+    {
+        xdg_popup_destroy(xdgpopup);
+        xdg_surface_destroy(xdgsurface);
+    }
+}
+
+void mfa::XdgPopupWindow::create_role(xdg_surface* parent, xdg_positioner* positioner)
 {
     static xdg_popup_listener const shell_popup_listener{
         .configure = [](void* ctx, auto... args)
             {
                 static_cast<XdgPopupWindow*>(ctx)->handle_xdg_popup_configure(args...);
             },
-        .popup_done = [](auto...) {},
-        .repositioned = [](auto...) {}};
+        .popup_done = [](void* ctx, auto... args)
+            {
+                static_cast<XdgPopupWindow*>(ctx)->handle_xdg_popup_done(args...);
+            },
+        .repositioned = [](void* ctx, auto... args)
+            {
+                static_cast<XdgPopupWindow*>(ctx)->handle_xdg_popup_repositioned(args...);
+            }};
     static xdg_surface_listener const shell_surface_listener{.configure = [](void* ctx, auto... args) {
         static_cast<XdgPopupWindow*>(ctx)->handle_xdg_surface_configure(args...);
     }};
 
+    xdgsurface = xdg_wm_base_get_xdg_surface(Globals::instance().wm_base(), static_cast<wl_surface*>(*this));
+    xdgpopup = xdg_surface_get_popup(xdgsurface, parent, positioner);
     xdg_popup_add_listener(xdgpopup, &shell_popup_listener, this);
     xdg_surface_add_listener(xdgsurface, &shell_surface_listener, this);
 }
 
-mfa::XdgPopupWindow::~XdgPopupWindow()
+void mfa::XdgPopupWindow::detach()
 {
+    // A reposition in flight is never answered once the role is destroyed
+    reposition_requests.cancel();
+
     xdg_popup_destroy(xdgpopup);
     xdg_surface_destroy(xdgsurface);
+    xdgpopup = nullptr;
+    xdgsurface = nullptr;
+
+    unmap();
+}
+
+void mfa::XdgPopupWindow::attach(xdg_surface* parent, xdg_positioner* positioner, int32_t width, int32_t height)
+{
+    resize(width, height);
+    pending_width = 0;
+    pending_height = 0;
+
+    create_role(parent, positioner);
+
+    // Commit without a buffer to get the initial configure, which draws the popup
+    wl_surface_commit(static_cast<wl_surface*>(*this));
 }
 
 void mfa::XdgPopupWindow::handle_mouse_button(
@@ -48,12 +92,52 @@ void mfa::XdgPopupWindow::handle_mouse_button(
     Window::handle_mouse_button(pointer, serial, time, button, state);
 }
 
-void mfa::XdgPopupWindow::handle_xdg_surface_configure(xdg_surface* surface, uint32_t serial)
+void mfa::XdgPopupWindow::reposition()
 {
     auto* window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
-    std::cout << "Window " << window->id << " - ";
+    if (xdg_popup_get_version(xdgpopup) < XDG_POPUP_REPOSITION_SINCE_VERSION)
+    {
+        MFA_LOG(warning, "xdg", "Window ", window->id, " - The compositor does not support repositioning popups");
+        return;
+    }
+
+    if (auto const token{reposition_requests.request(window->id)})
+    {
+        send_reposition(token);
+    }
+}
+
+void mfa::XdgPopupWindow::send_reposition(uint32_t token)
+{
+    auto* window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
+    xdg_popup_reposition(
+        xdgpopup,
+        Globals::instance().xdg_positioner_for(window->positioner, {width(), height()}),
+        token);
+}
 
-    std::cout << "Received xdg_surface_configure" << std::endl;
+void mfa::XdgPopupWindow::replay_popup_configure(int32_t width, int32_t height)
+{
+    pending_width = width;
+    pending_height = height;
+}
+
+void mfa::XdgPopupWindow::replay_surface_configure()
+{
+    // A pooled popup has no role to be configured
+    if (!xdgpopup) return;
+
+    resize(pending_width, pending_height);
+    show();
+}
+
+void mfa::XdgPopupWindow::handle_xdg_surface_configure(xdg_surface* surface, uint32_t serial)
+{
+    auto* window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
+    MFA_LOG(debug, "xdg", "Window ", window->id, " - Received xdg_surface_configure");
+    Tracer::instance().instant("configure", window->id);
+    Stats::instance().increment(Stats::Counter::configures);
+    EventRecorder::instance().record(EventRecorder::Kind::surface_configure, window->id, {serial});
 
     resize(pending_width, pending_height);
 
@@ -70,11 +154,35 @@ void mfa::XdgPopupWindow::handle_xdg_popup_configure(
     int32_t height)
 {
     auto* window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
-    std::cout << "Window " << window->id << " - ";
-
-    std::cout << "Received xdg_popup_configure: x: "
-        << x << ", y: " << y << ", width " << width << ", height " << height << std::endl;
+    MFA_LOG(debug, "xdg", "Window ", window->id, " - Received xdg_popup_configure: x: ", x, ", y: ", y, ", width ",
+        width, ", height ", height);
+    EventRecorder::instance().record(
+        EventRecorder::Kind::popup_configure,
+        window->id,
+        {static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(width),
+         static_cast<uint32_t>(height)});
 
     pending_width = width;
     pending_height = height;
 }
+
+void mfa::XdgPopupWindow::handle_xdg_popup_repositioned(xdg_popup* /*popup*/, uint32_t token)
+{
+    auto* window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
+    EventRecorder::instance().record(EventRecorder::Kind::repositioned, window->id, {token});
+
+    // The new position comes with the configure events that follow, which reuse the surface and its buffers
+    if (auto const next_token{reposition_requests.handle_repositioned(token, window->id)})
+    {
+        send_reposition(next_token);
+    }
+}
+
+void mfa::XdgPopupWindow::handle_xdg_popup_done(xdg_popup* /*popup*/)
+{
+    auto* window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
+    MFA_LOG(debug, "xdg", "Window ", window->id, " - Received xdg_popup_done");
+
+    // A dismissed popup is not sent repositioned for the request in flight
+    reposition_requests.cancel();
+}
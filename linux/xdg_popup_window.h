@@ -2,6 +2,7 @@
 #define XDG_POPUP_WINDOW_H_
 
 #include "window.h"
+#include "reposition_requests.h"
 
 struct xdg_popup;
 struct xdg_positioner;
@@ -22,9 +23,21 @@ public:
 
     explicit operator xdg_surface*() const { return xdgsurface; }
 
+    // Asks the compositor to place the popup with the positioner of its MirWindow, keeping its surface and buffers
+    void reposition();
+
+    // Takes the popup role off the surface, keeping the surface and buffers for a later attach
+    void detach();
+    // Gives the surface a popup role again, as a child of parent placed by positioner
+    void attach(xdg_surface* parent, xdg_positioner* positioner, int32_t width, int32_t height);
+
     void handle_mouse_button(wl_pointer* pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state)
         override;
 
+    // Apply configure events replayed by EventReplayer as the compositor's would be, without acknowledging them
+    void replay_popup_configure(int32_t width, int32_t height);
+    void replay_surface_configure();
+
 protected:
     XdgPopupWindow(XdgPopupWindow&&) = default;
     XdgPopupWindow& operator=(XdgPopupWindow&&) = default;
@@ -36,8 +49,14 @@ private:
     int32_t pending_width{};
     int32_t pending_height{};
 
+    RepositionRequests reposition_requests;
+
+    void create_role(xdg_surface* parent, xdg_positioner* positioner);
+    void send_reposition(uint32_t token);
     void handle_xdg_surface_configure(xdg_surface* surface, uint32_t serial);
     void handle_xdg_popup_configure(xdg_popup* popup, int32_t x, int32_t y, int32_t width, int32_t height);
+    void handle_xdg_popup_repositioned(xdg_popup* popup, uint32_t token);
+    void handle_xdg_popup_done(xdg_popup* popup);
 
     virtual void show() = 0;
 
@@ -1,11 +1,43 @@
 #include "xdg_toplevel_window.h"
+#include "event_recorder.h"
+#include "event_replayer.h"
 #include "globals.h"
+#include "logger.h"
 #include "mir_window.h"
+#include "stats.h"
+#include "tracer.h"
 #include "xdg-shell.h"
 
 #include <linux/input-event-codes.h>
 
-#include <iostream>
+namespace
+{
+auto resize_edge(mir_flutter_app::HitRegion region) -> xdg_toplevel_resize_edge
+{
+    using mir_flutter_app::HitRegion;
+    switch (region)
+    {
+    case HitRegion::resize_top:
+        return XDG_TOPLEVEL_RESIZE_EDGE_TOP;
+    case HitRegion::resize_bottom:
+        return XDG_TOPLEVEL_RESIZE_EDGE_BOTTOM;
+    case HitRegion::resize_left:
+        return XDG_TOPLEVEL_RESIZE_EDGE_LEFT;
+    case HitRegion::resize_right:
+        return XDG_TOPLEVEL_RESIZE_EDGE_RIGHT;
+    case HitRegion::resize_top_left:
+        return XDG_TOPLEVEL_RESIZE_EDGE_TOP_LEFT;
+    case HitRegion::resize_top_right:
+        return XDG_TOPLEVEL_RESIZE_EDGE_TOP_RIGHT;
+    case HitRegion::resize_bottom_left:
+        return XDG_TOPLEVEL_RESIZE_EDGE_BOTTOM_LEFT;
+    case HitRegion::resize_bottom_right:
+        return XDG_TOPLEVEL_RESIZE_EDGE_BOTTOM_RIGHT;
+    default:
+        return XDG_TOPLEVEL_RESIZE_EDGE_NONE;
+    }
+}
+}
 
 namespace mfa = mir_flutter_app;
 
@@ -45,9 +77,20 @@ void mfa::XdgToplevelWindow::handle_mouse_button(
 {
     Window::handle_mouse_button(pointer, serial, time, button, state);
 
+    // The serials of replayed presses were never sent to this session, so the compositor would reject the grab
+    if (EventReplayer::replaying()) return;
+
+    // Presses on the decorations are handled by the derived classes
     if (button == BTN_LEFT && state == WL_POINTER_BUTTON_STATE_PRESSED)
     {
-        xdg_toplevel_move(xdgtoplevel, Globals::instance().seat(), serial);
+        if (auto const edge{resize_edge(hovered)}; edge != XDG_TOPLEVEL_RESIZE_EDGE_NONE)
+        {
+            xdg_toplevel_resize(xdgtoplevel, Globals::instance().seat(), serial, edge);
+        }
+        else if (hovered == HitRegion::title_bar || hovered == HitRegion::client)
+        {
+            xdg_toplevel_move(xdgtoplevel, Globals::instance().seat(), serial);
+        }
     }
 
     if (button == BTN_RIGHT && state == WL_POINTER_BUTTON_STATE_PRESSED)
@@ -56,14 +99,113 @@ void mfa::XdgToplevelWindow::handle_mouse_button(
     }
 }
 
+void mfa::XdgToplevelWindow::handle_mouse_enter(wl_pointer* pointer, uint32_t serial, double x, double y)
+{
+    Window::handle_mouse_enter(pointer, serial, x, y);
+    update_hovered(x, y);
+}
+
+void mfa::XdgToplevelWindow::handle_mouse_leave(wl_pointer* pointer, uint32_t serial)
+{
+    Window::handle_mouse_leave(pointer, serial);
+    if (hovered == HitRegion::none) return;
+
+    hovered = HitRegion::none;
+    show_hovered();
+}
+
+void mfa::XdgToplevelWindow::handle_mouse_motion(wl_pointer* pointer, uint32_t time, double x, double y)
+{
+    Window::handle_mouse_motion(pointer, time, x, y);
+    update_hovered(x, y);
+}
+
+void mfa::XdgToplevelWindow::update_hit_regions()
+{
+    if (width() == hit_regions_width && height() == hit_regions_height && is_maximized_ == hit_regions_maximized)
+    {
+        return;
+    }
+    hit_regions_width = width();
+    hit_regions_height = height();
+    hit_regions_maximized = is_maximized_;
+
+    double const w{static_cast<double>(width())};
+    double const h{static_cast<double>(height())};
+
+    std::vector<HitRegions::Area> areas{{HitRegion::client, 0, 0, w, h}};
+    auto const decorations{decoration_areas(width(), height())};
+    areas.insert(areas.end(), decorations.begin(), decorations.end());
+
+    // A maximized window cannot be resized
+    if (!is_maximized_)
+    {
+        double const b{resize_border_width};
+        double const c{resize_corner_size};
+        areas.insert(areas.end(), {
+            {HitRegion::resize_top, 0, 0, w, b},
+            {HitRegion::resize_bottom, 0, h - b, w, h},
+            {HitRegion::resize_left, 0, 0, b, h},
+            {HitRegion::resize_right, w - b, 0, w, h},
+            {HitRegion::resize_top_left, 0, 0, c, c},
+            {HitRegion::resize_top_right, w - c, 0, w, c},
+            {HitRegion::resize_bottom_left, 0, h - c, c, h},
+            {HitRegion::resize_bottom_right, w - c, h - c, w, h}});
+    }
+
+    hit_regions = HitRegions{areas};
+
+    // The pointer may now be over a different region without having moved
+    if (hovered != HitRegion::none)
+    {
+        update_hovered(pointer_x, pointer_y);
+    }
+}
+
+void mfa::XdgToplevelWindow::update_hovered(double x, double y)
+{
+    pointer_x = x;
+    pointer_y = y;
+
+    auto const region{hit_regions.at(x, y)};
+    if (region == hovered) return;
+
+    hovered = region;
+    show_hovered();
+}
+
 void mfa::XdgToplevelWindow::handle_xdg_surface_configure(xdg_surface* surface, uint32_t serial)
 {
     auto* window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
-    std::cout << "Window " << window->id << " - ";
+    MFA_LOG(debug, "xdg", "Window ", window->id, " - Received xdg_surface_configure");
+    Tracer::instance().instant("configure", window->id);
+    Stats::instance().increment(Stats::Counter::configures);
+    EventRecorder::instance().record(EventRecorder::Kind::surface_configure, window->id, {serial});
+
+    apply_configure();
+
+    xdg_surface_ack_configure(surface, serial);
+}
+
+void mfa::XdgToplevelWindow::replay_toplevel_configure(int32_t width, int32_t height, uint32_t states)
+{
+    is_activated = states & EventRecorder::activated_state;
+    is_suspended = states & EventRecorder::suspended_state;
+    is_maximized_ = states & EventRecorder::maximized_state;
+    pending_width = width;
+    pending_height = height;
+}
 
-    std::cout << "Received xdg_surface_configure" << std::endl;
+void mfa::XdgToplevelWindow::replay_surface_configure()
+{
+    apply_configure();
+}
 
+void mfa::XdgToplevelWindow::apply_configure()
+{
     resize(pending_width, pending_height);
+    set_suspended(is_suspended);
+    update_hit_regions();
 
     if (is_activated)
     {
@@ -73,8 +215,6 @@ void mfa::XdgToplevelWindow::handle_xdg_surface_configure(xdg_surface* surface,
     {
         show_unactivated();
     }
-
-    xdg_surface_ack_configure(surface, serial);
 }
 
 void mfa::XdgToplevelWindow::handle_xdg_toplevel_configure(
@@ -84,11 +224,12 @@ void mfa::XdgToplevelWindow::handle_xdg_toplevel_configure(
     wl_array* states)
 {
     auto* window{Globals::instance().window_for(static_cast<wl_surface*>(*this))};
-    std::cout << "Window " << window->id << " - ";
-
-    std::cout << "Received xdg_toplevel_configure: width: " << width << ", height: " << height << std::endl;
+    MFA_LOG(debug, "xdg", "Window ", window->id, " - Received xdg_toplevel_configure: width: ", width, ", height: ",
+        height);
 
     is_activated = false;
+    is_suspended = false;
+    is_maximized_ = false;
     pending_width = width;
     pending_height = height;
 
@@ -100,5 +241,22 @@ void mfa::XdgToplevelWindow::handle_xdg_toplevel_configure(
         {
             is_activated = true;
         }
+        else if (*state == XDG_TOPLEVEL_STATE_SUSPENDED)
+        {
+            is_suspended = true;
+        }
+        else if (*state == XDG_TOPLEVEL_STATE_MAXIMIZED)
+        {
+            is_maximized_ = true;
+        }
     }
+
+    EventRecorder::instance().record(
+        EventRecorder::Kind::toplevel_configure,
+        window->id,
+        {static_cast<uint32_t>(width),
+         static_cast<uint32_t>(height),
+         (is_activated ? EventRecorder::activated_state : 0) |
+             (is_suspended ? EventRecorder::suspended_state : 0) |
+             (is_maximized_ ? EventRecorder::maximized_state : 0)});
 }
@@ -1,8 +1,11 @@
 #ifndef XDG_TOPLEVEL_WINDOW_H_
 #define XDG_TOPLEVEL_WINDOW_H_
 
+#include "hit_regions.h"
 #include "window.h"
 
+#include <vector>
+
 struct wl_array;
 struct xdg_surface;
 struct xdg_toplevel;
@@ -18,26 +21,66 @@ public:
     explicit operator xdg_surface*() const { return xdgsurface; }
     explicit operator xdg_toplevel*() const { return xdgtoplevel; }
 
+    void handle_mouse_enter(wl_pointer* pointer, uint32_t serial, double x, double y) override;
+    void handle_mouse_leave(wl_pointer* pointer, uint32_t serial) override;
+    void handle_mouse_motion(wl_pointer* pointer, uint32_t time, double x, double y) override;
     void handle_mouse_button(wl_pointer* pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state)
         override;
 
+    // Apply configure events replayed by EventReplayer as the compositor's would be, without acknowledging them.
+    // states is a set of EventRecorder's *_state bits.
+    void replay_toplevel_configure(int32_t width, int32_t height, uint32_t states);
+    void replay_surface_configure();
+
 protected:
+    auto is_maximized() const -> bool { return is_maximized_; }
+    // Region under the pointer, or none if the pointer is not over the window
+    auto hovered_region() const -> HitRegion { return hovered; }
+
+    // Areas of the decorations of a window of the given size. They take precedence over the client area, which
+    // covers the whole window, and are overridden by the resize borders.
+    virtual auto decoration_areas(int32_t width, int32_t height) const -> std::vector<HitRegions::Area>
+    {
+        return {};
+    }
+
     XdgToplevelWindow(XdgToplevelWindow&&) = default;
     XdgToplevelWindow& operator=(XdgToplevelWindow&&) = default;
 
 private:
+    // Width of the band along each edge, and size of the square at each corner, that resize the window
+    static int const resize_border_width{6};
+    static int const resize_corner_size{16};
+
     xdg_surface* xdgsurface;
     xdg_toplevel* xdgtoplevel;
 
     bool is_activated{};
+    bool is_suspended{};
+    bool is_maximized_{};
     int32_t pending_width{};
     int32_t pending_height{};
 
     void handle_xdg_surface_configure(xdg_surface* surface, uint32_t serial);
     void handle_xdg_toplevel_configure(xdg_toplevel* toplevel, int32_t width, int32_t height, wl_array* states);
+    // Applies the state of the last toplevel configure
+    void apply_configure();
+
+    HitRegions hit_regions;
+    // Size and maximized state the hit regions were laid out for
+    int32_t hit_regions_width{};
+    int32_t hit_regions_height{};
+    bool hit_regions_maximized{};
+    HitRegion hovered{};
+    double pointer_x{};
+    double pointer_y{};
+
+    void update_hit_regions();
+    void update_hovered(double x, double y);
 
     virtual void show_activated() = 0;
     virtual void show_unactivated() = 0;
+    virtual void show_hovered() {}
 
     XdgToplevelWindow(XdgToplevelWindow const&) = delete;
     XdgToplevelWindow& operator=(XdgToplevelWindow const&) = delete;